@@ -45,6 +45,10 @@
 
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
+/* NVIC priority of the LTDC and DMA2D interrupts, which give semaphores and
+   notifications: one step less urgent than the most urgent priority allowed
+   to call the FreeRTOS FromISR API */
+#define GRAPHICS_IRQ_PRIORITY  (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY + 1)
 /* Exported macro ------------------------------------------------------------*/
 #define LOBYTE(x)  ((uint8_t)(x & 0x00FF))
 #define HIBYTE(x)  ((uint8_t)((x & 0xFF00) >>8)) 
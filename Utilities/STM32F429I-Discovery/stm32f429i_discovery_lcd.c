@@ -425,6 +425,17 @@ void LCD_SetLayer(uint32_t Layerx)
   }
 }  
 
+/**
+  * @brief  Sets the frame buffer the drawing functions write to, keeping the
+  *         current layer. Used to draw into a back buffer of the layer.
+  * @param  Address: start address of the frame buffer in SDRAM.
+  * @retval None
+  */
+void LCD_SetFrameBuffer(uint32_t Address)
+{
+  CurrentFrameBuffer = Address;
+}
+
 /**
   * @brief  Sets the LCD Text and Background colors.
   * @param  TextColor: specifies the Text Color.
@@ -539,12 +550,29 @@ void LCD_ClearLine(uint16_t Line)
   */
 void LCD_Clear(uint16_t Color)
 {
-  uint32_t index = 0;
+  DMA2D_InitTypeDef      DMA2D_InitStruct;
+  
+  /* erase memory with a DMA2D register to memory transfer, one frame only:
+     the next buffer may start right after it */
+  DMA2D_DeInit();
+  DMA2D_InitStruct.DMA2D_Mode = DMA2D_R2M;       
+  DMA2D_InitStruct.DMA2D_CMode = DMA2D_RGB565;      
+  DMA2D_InitStruct.DMA2D_OutputGreen = (0x07E0 & Color) >> 5;      
+  DMA2D_InitStruct.DMA2D_OutputBlue = 0x001F & Color;     
+  DMA2D_InitStruct.DMA2D_OutputRed = (0xF800 & Color) >> 11;                
+  DMA2D_InitStruct.DMA2D_OutputAlpha = 0x0F;                  
+  DMA2D_InitStruct.DMA2D_OutputMemoryAdd = CurrentFrameBuffer;                
+  DMA2D_InitStruct.DMA2D_OutputOffset = 0;                
+  DMA2D_InitStruct.DMA2D_NumberOfLine = LCD_PIXEL_HEIGHT;            
+  DMA2D_InitStruct.DMA2D_PixelPerLine = LCD_PIXEL_WIDTH;
+  DMA2D_Init(&DMA2D_InitStruct); 
   
-  /* erase memory */
-  for (index = 0x00; index < BUFFER_OFFSET; index++)
+  /* Start Transfer */ 
+  DMA2D_StartTransfer();
+  
+  /* Wait for CTC Flag activation */
+  while(DMA2D_GetFlagStatus(DMA2D_FLAG_TC) == RESET)
   {
-    *(__IO uint16_t*)(CurrentFrameBuffer + (2*index)) = Color;
   } 
 }
 
@@ -263,6 +263,7 @@ void     LCD_Init(void);
 void     LCD_LayerInit(void);
 void     LCD_ChipSelect(FunctionalState NewState);
 void     LCD_SetLayer(uint32_t Layerx);
+void     LCD_SetFrameBuffer(uint32_t Address);
 void     LCD_SetColors(uint16_t _TextColor, uint16_t _BackColor); 
 void     LCD_GetColors(uint16_t *_TextColor, uint16_t *_BackColor);
 void     LCD_SetTextColor(uint16_t Color);
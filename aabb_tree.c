@@ -0,0 +1,388 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "aabb_tree.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define IS_LEAF(node)                   ((node)->child[0] == AABB_TREE_NULL)
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+typedef struct Join_s
+{
+    const AabbTree_t* tree;
+    bool (*iter)(const float* rect, int item, const float* other_rect, int other_item, void* udata);
+    void* udata;
+}Join_t;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static bool overlaps(const float* a, const float* b)
+{
+    return a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3];
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool contains(const float* outer, const float* inner)
+{
+    return outer[0] <= inner[0] && outer[1] <= inner[1] && inner[2] <= outer[2] && inner[3] <= outer[3];
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void merge(const float* a, const float* b, float* out)
+{
+    out[0] = (a[0] < b[0]) ? a[0] : b[0];
+    out[1] = (a[1] < b[1]) ? a[1] : b[1];
+    out[2] = (a[2] > b[2]) ? a[2] : b[2];
+    out[3] = (a[3] > b[3]) ? a[3] : b[3];
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Half the perimeter, which is what a box costs in 2D: the chance that a random query hits it grows with it
+static float perimeter(const float* box)
+{
+    return (box[2] - box[0]) + (box[3] - box[1]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void fatten(const AabbTree_t* tree, AabbNode_t* leaf)
+{
+    leaf->box[0] = leaf->rect[0] - tree->margin;
+    leaf->box[1] = leaf->rect[1] - tree->margin;
+    leaf->box[2] = leaf->rect[2] + tree->margin;
+    leaf->box[3] = leaf->rect[3] + tree->margin;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static int allocate(AabbTree_t* tree)
+{
+    int node = tree->free_list;
+
+    tree->free_list = tree->nodes[node].parent;
+    tree->nodes[node].child[0] = AABB_TREE_NULL;
+    tree->nodes[node].child[1] = AABB_TREE_NULL;
+    return node;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void release(AabbTree_t* tree, int node)
+{
+    tree->nodes[node].parent = tree->free_list;
+    tree->free_list = (uint16_t)node;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Node after the subtree under node in depth first order, AABB_TREE_NULL past the last one. Walking the tree through
+// the parent links needs no stack, however deep it got.
+static int skip(const AabbTree_t* tree, int node)
+{
+    const AabbNode_t* nodes = tree->nodes;
+
+    while(node != tree->root)
+    {
+        int parent = nodes[node].parent;
+
+        if(nodes[parent].child[0] == node)
+            return nodes[parent].child[1];
+        node = parent;
+    }
+    return AABB_TREE_NULL;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Swaps a child of the branch with a child of its other child when that shrinks the perimeter of the latter. The
+// branch keeps the same leaves, so its own box stays as it is.
+static void rotate(AabbTree_t* tree, int branch)
+{
+    AabbNode_t* nodes = tree->nodes;
+    float best_gain = 0.0f;
+    int best_side = -1;
+    int best_k = 0;
+
+    for(int side = 0; side < 2; side++)
+    {
+        const AabbNode_t* lower = &nodes[nodes[branch].child[!side]];
+        const float* moving = nodes[nodes[branch].child[side]].box;
+
+        if(IS_LEAF(lower))
+            continue;
+
+        for(int k = 0; k < 2; k++)
+        {
+            // The moving child takes the place of grandchild k, the other grandchild stays next to it
+            float box[4];
+            float gain;
+
+            merge(moving, nodes[lower->child[!k]].box, box);
+            gain = perimeter(lower->box) - perimeter(box);
+            if(gain > best_gain)
+            {
+                best_gain = gain;
+                best_side = side;
+                best_k = k;
+            }
+        }
+    }
+
+    if(best_side < 0)
+        return;
+
+    int moving = nodes[branch].child[best_side];
+    int lower = nodes[branch].child[!best_side];
+    int rising = nodes[lower].child[best_k];
+
+    nodes[branch].child[best_side] = (uint16_t)rising;
+    nodes[rising].parent = (uint16_t)branch;
+    nodes[lower].child[best_k] = (uint16_t)moving;
+    nodes[moving].parent = (uint16_t)lower;
+    merge(nodes[nodes[lower].child[0]].box, nodes[nodes[lower].child[1]].box, nodes[lower].box);
+    tree->rotations++;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Pairs between the leaves under a and those under b, which share none. The bigger branch is split first, so both
+// sides shrink at about the same pace and disjoint boxes cut the walk short early.
+static bool join_cross(const Join_t* join, int a, int b)
+{
+    const AabbNode_t* nodes = join->tree->nodes;
+    const AabbNode_t* node_a = &nodes[a];
+    const AabbNode_t* node_b = &nodes[b];
+
+    if(IS_LEAF(node_a) && IS_LEAF(node_b))
+    {
+        if(!overlaps(node_a->rect, node_b->rect))
+            return true;
+        return join->iter(node_a->rect, node_a->item, node_b->rect, node_b->item, join->udata);
+    }
+    if(!overlaps(node_a->box, node_b->box))
+        return true;
+
+    if(IS_LEAF(node_b) || (!IS_LEAF(node_a) && perimeter(node_a->box) >= perimeter(node_b->box)))
+        return join_cross(join, node_a->child[0], b) && join_cross(join, node_a->child[1], b);
+    return join_cross(join, a, node_b->child[0]) && join_cross(join, a, node_b->child[1]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Every pair under a node is either under one of its children or has one leaf under each
+static bool join_node(const Join_t* join, int node)
+{
+    const AabbNode_t* current = &join->tree->nodes[node];
+
+    if(IS_LEAF(current))
+        return true;
+    return join_node(join, current->child[0]) && join_node(join, current->child[1]) &&
+           join_cross(join, current->child[0], current->child[1]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Brings the boxes from node up to the root in line with their children, rotating each branch on the way
+static void refit(AabbTree_t* tree, int node)
+{
+    AabbNode_t* nodes = tree->nodes;
+
+    while(node != AABB_TREE_NULL)
+    {
+        merge(nodes[nodes[node].child[0]].box, nodes[nodes[node].child[1]].box, nodes[node].box);
+        rotate(tree, node);
+        node = nodes[node].parent;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Descends towards the node the new box is cheapest to pair up with. A new branch costs its perimeter, and every
+// branch above it grows by as much as the box adds to them.
+static int choose_sibling(const AabbTree_t* tree, const float* box)
+{
+    const AabbNode_t* nodes = tree->nodes;
+    int node = tree->root;
+
+    while(!IS_LEAF(&nodes[node]))
+    {
+        float combined[4];
+        float cost, inherited;
+        float child_cost[2];
+
+        merge(nodes[node].box, box, combined);
+        cost = perimeter(combined);
+        inherited = cost - perimeter(nodes[node].box);
+
+        for(int k = 0; k < 2; k++)
+        {
+            const AabbNode_t* child = &nodes[nodes[node].child[k]];
+
+            merge(child->box, box, combined);
+            child_cost[k] = perimeter(combined) + inherited;
+            if(!IS_LEAF(child))
+                child_cost[k] -= perimeter(child->box);
+        }
+
+        if(cost <= child_cost[0] && cost <= child_cost[1])
+            break;
+        node = nodes[node].child[child_cost[1] < child_cost[0]];
+    }
+    return node;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void aabb_tree_init(AabbTree_t* tree, float margin, AabbNode_t* nodes, int node_count)
+{
+    tree->margin = margin;
+    tree->nodes = nodes;
+    tree->node_count = node_count;
+    tree->root = AABB_TREE_NULL;
+    tree->count = 0;
+    tree->refits = 0;
+    tree->rotations = 0;
+
+    tree->free_list = AABB_TREE_NULL;
+    for(int i = node_count - 1; i >= 0; i--)
+    {
+        release(tree, i);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+int aabb_tree_insert(AabbTree_t* tree, const float* rect, int item)
+{
+    AabbNode_t* nodes = tree->nodes;
+    int leaf, sibling, branch, parent;
+
+    // A leaf and the branch joining it to the tree
+    if(2 * tree->count + 1 > tree->node_count)
+        return -1;
+
+    leaf = allocate(tree);
+    for(int k = 0; k < 4; k++)
+    {
+        nodes[leaf].rect[k] = rect[k];
+    }
+    fatten(tree, &nodes[leaf]);
+    nodes[leaf].item = (uint16_t)item;
+    tree->count++;
+
+    if(tree->root == AABB_TREE_NULL)
+    {
+        nodes[leaf].parent = AABB_TREE_NULL;
+        tree->root = (uint16_t)leaf;
+        return leaf;
+    }
+
+    sibling = choose_sibling(tree, nodes[leaf].box);
+    parent = nodes[sibling].parent;
+    branch = allocate(tree);
+    nodes[branch].parent = (uint16_t)parent;
+    nodes[branch].child[0] = (uint16_t)sibling;
+    nodes[branch].child[1] = (uint16_t)leaf;
+    nodes[sibling].parent = (uint16_t)branch;
+    nodes[leaf].parent = (uint16_t)branch;
+
+    if(parent == AABB_TREE_NULL)
+        tree->root = (uint16_t)branch;
+    else
+        nodes[parent].child[nodes[parent].child[1] == sibling] = (uint16_t)branch;
+
+    refit(tree, branch);
+    return leaf;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void aabb_tree_remove(AabbTree_t* tree, int leaf)
+{
+    AabbNode_t* nodes = tree->nodes;
+    int parent = nodes[leaf].parent;
+
+    tree->count--;
+    release(tree, leaf);
+    if(parent == AABB_TREE_NULL)
+    {
+        tree->root = AABB_TREE_NULL;
+        return;
+    }
+
+    // The sibling takes the place of the branch they shared
+    int grandparent = nodes[parent].parent;
+    int sibling = nodes[parent].child[nodes[parent].child[0] == leaf];
+
+    nodes[sibling].parent = (uint16_t)grandparent;
+    release(tree, parent);
+    if(grandparent == AABB_TREE_NULL)
+    {
+        tree->root = (uint16_t)sibling;
+        return;
+    }
+
+    nodes[grandparent].child[nodes[grandparent].child[1] == parent] = (uint16_t)sibling;
+    refit(tree, grandparent);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool aabb_tree_move(AabbTree_t* tree, int leaf, const float* rect)
+{
+    AabbNode_t* node = &tree->nodes[leaf];
+
+    for(int k = 0; k < 4; k++)
+    {
+        node->rect[k] = rect[k];
+    }
+    if(contains(node->box, rect))
+        return false;
+
+    fatten(tree, node);
+    refit(tree, node->parent);
+    tree->refits++;
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool aabb_tree_search(const AabbTree_t* tree, const float* rect,
+                      bool (*iter)(const float* rect, int item, void* udata), void* udata)
+{
+    const AabbNode_t* nodes = tree->nodes;
+    int node = tree->root;
+
+    while(node != AABB_TREE_NULL)
+    {
+        const AabbNode_t* current = &nodes[node];
+
+        if(!overlaps(current->box, rect))
+        {
+            node = skip(tree, node);
+        }
+        else if(IS_LEAF(current))
+        {
+            if(overlaps(current->rect, rect) && !iter(current->rect, current->item, udata))
+                return false;
+            node = skip(tree, node);
+        }
+        else
+        {
+            node = current->child[0];
+        }
+    }
+
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// One walk of the tree against itself, like rtree_self_join(). The recursion goes at most as deep as the two deepest
+// leaves together.
+bool aabb_tree_self_join(const AabbTree_t* tree,
+                         bool (*iter)(const float* rect, int item, const float* other_rect, int other_item,
+                                      void* udata),
+                         void* udata)
+{
+    Join_t join = { tree, iter, udata };
+
+    if(tree->root == AABB_TREE_NULL)
+        return true;
+    return join_node(&join, tree->root);
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+#ifndef __AABB_TREE_H
+#define __AABB_TREE_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Nodes for a number of items: one leaf each and one branch less than that
+#define AABB_TREE_NODES(count)          (2 * (count))
+#define AABB_TREE_NULL                  0xFFFF
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Rects are min x, min y, max x, max y like the rtree's
+typedef struct AabbNode_s
+{
+    float box[4];               // a leaf's fat box, or the union of a branch's children
+    float rect[4];              // leaves only, the item's own rect
+    uint16_t parent;            // next free node while on the free list
+    uint16_t child[2];          // AABB_TREE_NULL for a leaf
+    uint16_t item;
+}AabbNode_t;
+
+// Dynamic bounding volume tree for items that keep moving a little. Every leaf holds its item under a fat box, the rect
+// enlarged by margin on all sides, and the tree only changes when a rect leaves its fat box. The leaf then gets a new
+// fat box around the rect, its branches are refitted on the way up, and each of them is rotated when swapping a child
+// with a grandchild gives it a smaller perimeter. Leaves are never taken out and put back in for a move, so an item
+// jumping across the screen leaves its leaf where it was until the rotations catch up. All storage is supplied by the
+// caller: nodes needs AABB_TREE_NODES() entries, at most 65535 of them.
+typedef struct AabbTree_s
+{
+    float margin;
+    AabbNode_t* nodes;
+    int node_count;
+    uint16_t root;
+    uint16_t free_list;
+    int count;
+
+    uint32_t refits;            // leaves moved out of their fat box, never cleared by the tree
+    uint32_t rotations;         // children swapped with grandchildren, never cleared by the tree
+}AabbTree_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+void aabb_tree_init(AabbTree_t* tree, float margin, AabbNode_t* nodes, int node_count);
+// Returns the leaf holding the item, which identifies it to the other calls, or -1 when there are no nodes left
+int aabb_tree_insert(AabbTree_t* tree, const float* rect, int item);
+void aabb_tree_remove(AabbTree_t* tree, int leaf);
+// Returns true when the rect left the fat box and the tree had to change
+bool aabb_tree_move(AabbTree_t* tree, int leaf, const float* rect);
+// Same reports as rtree_search() and rtree_self_join(): items whose own rects overlap, touching counts. The self join
+// reports every overlapping pair once.
+bool aabb_tree_search(const AabbTree_t* tree, const float* rect,
+                      bool (*iter)(const float* rect, int item, void* udata), void* udata);
+bool aabb_tree_self_join(const AabbTree_t* tree,
+                         bool (*iter)(const float* rect, int item, const float* other_rect, int other_item,
+                                      void* udata),
+                         void* udata);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AABB_TREE_H */
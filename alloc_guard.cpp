@@ -0,0 +1,147 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "alloc_guard.h"
+#include <cstddef>
+#include <new>
+
+extern "C" {
+    #include <stdlib.h>
+    #include "rtree.h"
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Every block carries its size in front of it, so that freeing it can take it off the bytes in use
+#define HEADER_SIZE                     alignof(std::max_align_t)
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static uint32_t total_allocs;
+static uint32_t steady_allocs;
+static bool armed;
+static uint32_t bytes_in_use;
+static uint32_t bytes_peak;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static void* counting_malloc(size_t size)
+{
+    char* block;
+
+    total_allocs++;
+    if(armed)
+        steady_allocs++;
+
+    block = (char*)malloc(size + HEADER_SIZE);
+    if(!block)
+        return NULL;
+
+    *(size_t*)block = size;
+    bytes_in_use += size;
+    if(bytes_in_use > bytes_peak)
+        bytes_peak = bytes_in_use;
+    return block + HEADER_SIZE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void counting_free(void* ptr)
+{
+    char* block;
+
+    if(!ptr)
+        return;
+
+    block = (char*)ptr - HEADER_SIZE;
+    bytes_in_use -= *(size_t*)block;
+    free(block);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void* counting_new(size_t size)
+{
+    void* ptr = counting_malloc(size ? size : 1);
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+    if(!ptr)
+        throw std::bad_alloc();
+#endif
+    return ptr;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void alloc_guard_init(void)
+{
+    rtree_set_allocator(counting_malloc, counting_free);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void alloc_guard_arm(void)
+{
+    steady_allocs = 0;
+    armed = true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t alloc_guard_total(void)
+{
+    return total_allocs;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t alloc_guard_steady(void)
+{
+    return steady_allocs;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t alloc_guard_peak_bytes(void)
+{
+    return bytes_peak;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void* operator new(size_t size)
+{
+    return counting_new(size);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void* operator new[](size_t size)
+{
+    return counting_new(size);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void operator delete(void* ptr) noexcept
+{
+    counting_free(ptr);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void operator delete[](void* ptr) noexcept
+{
+    counting_free(ptr);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void operator delete(void* ptr, size_t size) noexcept
+{
+    (void)size;
+    counting_free(ptr);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void operator delete[](void* ptr, size_t size) noexcept
+{
+    (void)size;
+    counting_free(ptr);
+}
+// ---------------------------------------------------------------------------------------------------------------------
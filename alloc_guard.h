@@ -0,0 +1,31 @@
+#ifndef __ALLOC_GUARD_H
+#define __ALLOC_GUARD_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Counts the heap allocations of the simulation: operator new always, rtree.c once alloc_guard_init() installed the
+// counter as its allocator. alloc_guard_arm() marks the start of the steady state, after which a frame is expected to
+// allocate nothing, so alloc_guard_steady() must stay at zero. alloc_guard_peak_bytes() is the most bytes these
+// allocations ever held at once.
+void alloc_guard_init(void);
+void alloc_guard_arm(void);
+uint32_t alloc_guard_total(void);
+uint32_t alloc_guard_steady(void);
+uint32_t alloc_guard_peak_bytes(void);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ALLOC_GUARD_H */
@@ -3,25 +3,47 @@
 // ---------------------------------------------------------------------------------------------------------------------
 
 #include "app.h"
-#include "vector.hpp"
-#include <list>
+#include "display.h"
+#include "lcd_dma2d.h"
+#include "sprites.h"
+#include "dirty.h"
+#include "tiles.h"
+#include "profiler.h"
+#include "hud.h"
+#include "alloc_guard.h"
+#include "triple_buffer.hpp"
 
 extern "C" {
     #include "math.h"
+    #include <assert.h>
     #include <time.h>
     #include <stdlib.h>
     #include "rtree.h"
+    #include "grid.h"
+    #include "sap.h"
+    #include "aabb_tree.h"
+    #include "particles.h"
+    #include "ccd.h"
 }
 
+// IAR puts the standard library in the global namespace implicitly, other compilers need to be told
+using namespace std;
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Defines/macros
 // ---------------------------------------------------------------------------------------------------------------------
 #define LCD_WIDTH                       240
 #define LCD_HEIGHT                      320
 
+#ifndef CIRCLE_RADIUS
 #define CIRCLE_RADIUS                   6
+#endif
+#ifndef NUMBER_OF_PARTICLES
 #define NUMBER_OF_PARTICLES             80
+#endif
+#ifndef INITIAL_DIST_BETWEEN_PARTS
 #define INITIAL_DIST_BETWEEN_PARTS      8
+#endif
 #define MAX_PARTICLES_PER_ROW           (LCD_WIDTH / (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS)))
 #define MAX_PARTICLES_PER_COL           (LCD_HEIGHT / (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS)))
 #define MAX_PARTICLES                   (                                                                              \
@@ -36,10 +58,104 @@ extern "C" {
 
 #define MAX_FRICTION_RAND_MOD           10
 #define MAX_FRICTION                    0.1f
-#define REFRESH_RATE                    60 //Hz
-#define REFRESH_PERIOD                  ((uint32_t)((1.0/REFRESH_RATE) * 1000))
+#define SIMULATION_DT                   (1.0f / APP_SIMULATION_RATE)
+#ifndef MIN_INITIAL_SPEED
 #define MIN_INITIAL_SPEED               150
+#endif
+#ifndef MAX_INITIAL_SPEED
 #define MAX_INITIAL_SPEED               200 
+#endif
+
+// How contacts are found: particles moved a whole step and then tested for overlap, or swept along their path with
+// every contact resolved at the time it happens, so that a particle moving more than a contact distance per step cannot
+// pass through another one or through a wall
+#define COLLISION_MODE_DISCRETE         0
+#define COLLISION_MODE_CONTINUOUS       1
+
+#ifndef COLLISION_MODE
+#define COLLISION_MODE                  COLLISION_MODE_DISCRETE
+#endif
+
+// Broad phase used to find the candidate pairs of update_particles
+#define BROAD_PHASE_RTREE               0
+#define BROAD_PHASE_GRID                1
+#define BROAD_PHASE_SAP                 2
+#define BROAD_PHASE_AABB_TREE           3
+
+#ifndef BROAD_PHASE
+#if COLLISION_MODE == COLLISION_MODE_CONTINUOUS
+#define BROAD_PHASE                     BROAD_PHASE_AABB_TREE
+#else
+#define BROAD_PHASE                     BROAD_PHASE_GRID
+#endif
+#endif
+
+// The grid and the sweep and prune index particle centres a contact distance apart, swept paths need the trees
+#if COLLISION_MODE == COLLISION_MODE_CONTINUOUS && BROAD_PHASE != BROAD_PHASE_RTREE && \
+    BROAD_PHASE != BROAD_PHASE_AABB_TREE
+#error Continuous collisions need the rtree or the AABB tree broad phase
+#endif
+
+// How the rtree follows the particles once per frame: move the ones that changed inside the tree, or bulk load the whole
+// tree again
+#define RTREE_MAINTENANCE_INCREMENTAL   0
+#define RTREE_MAINTENANCE_REBUILD       1
+
+#ifndef RTREE_MAINTENANCE
+#define RTREE_MAINTENANCE               RTREE_MAINTENANCE_REBUILD
+#endif
+
+// Nodes of the rtree come from a static arena instead of the heap. A rebuilt tree is packed full, the incremental one
+// keeps every leaf at least 20% full, with headroom for splits and for the underfull leaves waiting to be reinserted
+#if RTREE_MAINTENANCE == RTREE_MAINTENANCE_REBUILD
+#define TREE_ARENA_LEAVES               ((NUMBER_OF_PARTICLES + RTREE_MAXITEMS - 1) / RTREE_MAXITEMS)
+#else
+#define TREE_ARENA_LEAVES               (NUMBER_OF_PARTICLES / 6 + 4)
+#endif
+#define TREE_ARENA_BRANCHES             (TREE_ARENA_LEAVES / 6 + 4)
+
+// Candidate pairs are collected into a fixed list and resolved in batches, a full list is resolved before it is reused
+#define PAIR_LIST_SIZE                  (2 * NUMBER_OF_PARTICLES)
+
+// Cells must be at least one contact distance wide, so that only the neighbouring cells have to be visited
+#define GRID_CELL_SIZE                  (2 * CIRCLE_RADIUS)
+
+// Overlaps on the sweep axis the sweep and prune keeps track of, past that it sweeps for them every step. Spread evenly
+// down the screen, each particle overlaps the others within two contact distances of it: twice that average leaves
+// room for crowds, up to what the set can index.
+#define SAP_PAIR_CAPACITY               MIN(NUMBER_OF_PARTICLES *                                                  \
+                                                (NUMBER_OF_PARTICLES * 4 * CIRCLE_RADIUS / LCD_HEIGHT + 1),         \
+                                            SAP_MAX_PAIRS)
+
+// How far a particle may stray from where its leaf was last fitted before the AABB tree has to follow it. Fatter boxes
+// save refits but overlap more of their neighbours, which costs the self join more once the particles crowd together.
+#define AABB_TREE_MARGIN                (CIRCLE_RADIUS / 2.0f)
+
+// Swept pairs the continuous solver times, the ones past that are resolved after the step like discrete contacts. A
+// particle resolves a few contacts per step at most, more is a crowd that the solver gives up on to keep the step
+// bounded.
+#define CCD_PAIR_CAPACITY               (4 * NUMBER_OF_PARTICLES)
+#define CCD_MAX_EVENTS                  (8 * NUMBER_OF_PARTICLES)
+
+// How the sprites reach the frame buffer: blended one by one by the DMA2D straight into SDRAM, or rendered by the CPU
+// into SRAM tiles that the DMA2D copies over whole
+#define RENDER_MODE_DIRECT              0
+#define RENDER_MODE_TILED               1
+
+#ifndef RENDER_MODE
+#define RENDER_MODE                     RENDER_MODE_DIRECT
+#endif
+
+// Frame rate, phase times, CPU load, contacts and heap use on the display overlay, over the top HUD_LINES of the screen
+#ifndef SHOW_HUD
+#define SHOW_HUD                        1
+#endif
+#define HUD_REFRESH_RATE                4
+#define HUD_LINES                       6
+#define HUD_PHASE_COLUMNS               15
+
+// The profiler phases app_simulate() closes, the rest belong to app_render()
+#define PHYSICS_PHASES                  (PROFILE_NARROW_PHASE + 1)
 
 #if NUMBER_OF_PARTICLES > MAX_PARTICLES
 #error Number of particles is greater than maximum number
@@ -49,6 +165,38 @@ extern "C" {
 // ---------------------------------------------------------------------------------------------------------------------
 // Private typedefs
 // ---------------------------------------------------------------------------------------------------------------------
+// Candidate contact found by the broad phase
+typedef struct Pair_s
+{
+    uint16_t a;
+    uint16_t b;
+}Pair_t;
+
+// What the render side gets to see of a simulation step, the pixel each particle is drawn at and its color, and what
+// the step cost
+typedef struct Snapshot_s
+{
+    int16_t x[NUMBER_OF_PARTICLES];
+    int16_t y[NUMBER_OF_PARTICLES];
+    uint16_t color[NUMBER_OF_PARTICLES];
+    uint32_t step;
+    uint32_t collisions;
+    uint32_t pairs;
+    uint32_t cycles[PHYSICS_PHASES];
+}Snapshot_t;
+
+// What the HUD adds up between two refreshes. Steps are counted as the snapshots show them, those the render task
+// skips are left out of the averages.
+typedef struct HudWindow_s
+{
+    uint32_t start;
+    uint32_t frames;
+    uint32_t last_step;
+    uint32_t steps;
+    uint32_t collisions;
+    uint32_t pairs;
+    uint32_t cycles[PHYSICS_PHASES];
+}HudWindow_t;
 
 
 
@@ -65,8 +213,61 @@ static const uint16_t colors[] =
 // ---------------------------------------------------------------------------------------------------------------------
 // Private variables
 // ---------------------------------------------------------------------------------------------------------------------
+PARTICLES_ALIGNED(static float particle_data[PARTICLES_FLOATS(NUMBER_OF_PARTICLES)]);
+static uint16_t particle_color[NUMBER_OF_PARTICLES];
+static ParticleStore_t particles;
+static AppStats_t stats;
+static Pair_t pairs[PAIR_LIST_SIZE];
+static int pair_count;
+static uint32_t step_count;
+// Simulation steps handed from app_simulate() to app_render(), which may run in different tasks. The drawing state
+// below belongs to the render side alone.
+static TripleBuffer<Snapshot_t> snapshots;
+static const Sprite_t* circle_sprite;
+// Where every particle was last drawn into each display buffer. A buffer that is drawn again still holds the frame
+// from DISPLAY_BUFFERS frames ago, so only what changed since then has to be redone.
+static int16_t drawn_x[DISPLAY_BUFFERS][NUMBER_OF_PARTICLES];
+static int16_t drawn_y[DISPLAY_BUFFERS][NUMBER_OF_PARTICLES];
+static bool drawn_valid[DISPLAY_BUFFERS];
+static DirtyRegion_t dirty;
+#if SHOW_HUD
+static HudWindow_t hud_window;
+#endif
+#if RENDER_MODE == RENDER_MODE_TILED
+static TileBins_t tiles;
+static uint16_t tile_start[TILE_COUNT(LCD_WIDTH, LCD_HEIGHT) + 1];
+static uint16_t tile_items[TILE_ITEMS(NUMBER_OF_PARTICLES, CIRCLE_RADIUS)];
+#endif
+
+#if BROAD_PHASE == BROAD_PHASE_RTREE
 static struct rtree *tr;
-static Particle_t particles[NUMBER_OF_PARTICLES];
+static uint64_t tree_arena[RTREE_ARENA_SIZE(sizeof(int), TREE_ARENA_LEAVES, TREE_ARENA_BRANCHES) / sizeof(uint64_t)];
+// Bulk load input, reordered by every load
+static rtree_coord_t tree_rects[NUMBER_OF_PARTICLES * 4];
+static int tree_items[NUMBER_OF_PARTICLES];
+#if RTREE_MAINTENANCE == RTREE_MAINTENANCE_INCREMENTAL
+// The rect every particle is stored under, which is what the tree has to be searched with to find it again
+static rtree_coord_t placed_rects[NUMBER_OF_PARTICLES * 4];
+#endif
+#elif BROAD_PHASE == BROAD_PHASE_GRID
+static Grid_t grid;
+static uint16_t grid_cell_start[GRID_CELLS(LCD_WIDTH, LCD_HEIGHT, GRID_CELL_SIZE) + 1];
+static uint16_t grid_items[NUMBER_OF_PARTICLES];
+#elif BROAD_PHASE == BROAD_PHASE_SAP
+static Sap_t sap;
+static SapEndpoint_t sap_endpoints[SAP_ENDPOINTS(NUMBER_OF_PARTICLES)];
+static SapPair_t sap_overlaps[SAP_PAIR_CAPACITY];
+static uint16_t sap_slots[SAP_SLOTS(SAP_PAIR_CAPACITY)];
+#elif BROAD_PHASE == BROAD_PHASE_AABB_TREE
+static AabbTree_t aabb_tree;
+static AabbNode_t aabb_nodes[AABB_TREE_NODES(NUMBER_OF_PARTICLES)];
+// The leaf every particle is stored in
+static int aabb_leaves[NUMBER_OF_PARTICLES];
+#endif
+#if COLLISION_MODE == COLLISION_MODE_CONTINUOUS
+static Ccd_t ccd;
+static uint32_t ccd_storage[CCD_WORDS(NUMBER_OF_PARTICLES, CCD_PAIR_CAPACITY)];
+#endif
 
 // ---------------------------------------------------------------------------------------------------------------------
 // Private prototypes
@@ -76,221 +277,682 @@ static Particle_t particles[NUMBER_OF_PARTICLES];
 // ---------------------------------------------------------------------------------------------------------------------
 // Private functions
 // ---------------------------------------------------------------------------------------------------------------------
+#if BROAD_PHASE == BROAD_PHASE_RTREE || BROAD_PHASE == BROAD_PHASE_AABB_TREE
+// Extent of a particle on one axis over the coming step. In continuous mode that is its whole path, and a path that
+// runs into a wall is folded back from it the way the bounce will fold it.
+static void sweep_axis(float pos, float vel, float lo, float hi, float* min, float* max)
+{
+#if COLLISION_MODE == COLLISION_MODE_CONTINUOUS
+    float end = pos + vel * SIMULATION_DT;
+    float low = MIN(pos, end);
+    float high = MAX(pos, end);
+    
+    if(high > hi)
+    {
+        low = MIN(low, 2 * hi - end);
+        high = hi;
+    }
+    if(low < lo)
+    {
+        high = MAX(high, 2 * lo - end);
+        low = lo;
+    }
+    *min = low - CIRCLE_RADIUS;
+    *max = high + CIRCLE_RADIUS;
+#else
+    *min = pos - CIRCLE_RADIUS;
+    *max = pos + CIRCLE_RADIUS;
+#endif
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void particle_bounds(int i, float* bounds)
+{
+    sweep_axis(particles.x[i], particles.vx[i], CIRCLE_RADIUS, LCD_WIDTH - CIRCLE_RADIUS, &bounds[0], &bounds[2]);
+    sweep_axis(particles.y[i], particles.vy[i], CIRCLE_RADIUS, LCD_HEIGHT - CIRCLE_RADIUS, &bounds[1], &bounds[3]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#endif
+
+#if BROAD_PHASE == BROAD_PHASE_RTREE
+static void particle_rect(int i, rtree_coord_t* rect)
+{
+    float bounds[4];
+    
+    particle_bounds(i, bounds);
+    rect[0] = RTREE_COORD_MIN(bounds[0]);
+    rect[1] = RTREE_COORD_MIN(bounds[1]);
+    rect[2] = RTREE_COORD_MAX(bounds[2]);
+    rect[3] = RTREE_COORD_MAX(bounds[3]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void load_tree(void)
+{
+    for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
+    {
+        particle_rect(i, &tree_rects[i * 4]);
+        tree_items[i] = i;
+#if RTREE_MAINTENANCE == RTREE_MAINTENANCE_INCREMENTAL
+        particle_rect(i, &placed_rects[i * 4]);
+#endif
+    }
+    
+    rtree_bulk_load(tr, tree_rects, tree_items, NUMBER_OF_PARTICLES);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+#if RTREE_MAINTENANCE == RTREE_MAINTENANCE_INCREMENTAL
+// Returns false when the arena had no room to move the particle, it then stays in the tree under its old rect
+static bool move_in_tree(int i)
+{
+    rtree_coord_t rect[4];
+    rtree_coord_t* placed = &placed_rects[i * 4];
+    
+    particle_rect(i, rect);
+    if(rect[0] == placed[0] && rect[1] == placed[1] && rect[2] == placed[2] && rect[3] == placed[3])
+        return true;
+    
+    if(!rtree_update(tr, placed, rect, &i))
+        return false;
+    for(int k = 0; k < 4; k++)
+    {
+        placed[k] = rect[k];
+    }
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#endif
+#elif BROAD_PHASE == BROAD_PHASE_AABB_TREE
+static void fill_aabb_tree(void)
+{
+    float box[4];
+    
+    for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
+    {
+        particle_bounds(i, box);
+        aabb_leaves[i] = aabb_tree_insert(&aabb_tree, box, i);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#endif
+
 static void initialize_particles(void)
 {
+#ifdef APP_RANDOM_SEED
+    srand(APP_RANDOM_SEED);
+#else
     srand(time(0));
-    memset(particles, 0, sizeof(particles));
-    tr = rtree_new(sizeof(struct city*), 2);
+#endif
+    particles_init(&particles, particle_data, particle_color, NUMBER_OF_PARTICLES);
+#if BROAD_PHASE == BROAD_PHASE_RTREE
+    tr = rtree_new(sizeof(int), 2);
+    // Only fails when the arena cannot even hold its own leaves, which is a build configuration error
+    bool arena_set = rtree_set_arena(tr, tree_arena, sizeof(tree_arena), TREE_ARENA_LEAVES);
+    assert(arena_set);
+    (void)arena_set;
+#elif BROAD_PHASE == BROAD_PHASE_GRID
+    grid_init(&grid, LCD_WIDTH, LCD_HEIGHT, GRID_CELL_SIZE, grid_cell_start, grid_items);
+#elif BROAD_PHASE == BROAD_PHASE_SAP
+    sap_init(&sap, CIRCLE_RADIUS, sap_endpoints, sap_overlaps, SAP_PAIR_CAPACITY, sap_slots);
+#elif BROAD_PHASE == BROAD_PHASE_AABB_TREE
+    aabb_tree_init(&aabb_tree, AABB_TREE_MARGIN, aabb_nodes, AABB_TREE_NODES(NUMBER_OF_PARTICLES));
+#endif
+#if COLLISION_MODE == COLLISION_MODE_CONTINUOUS
+    ccd_init(&ccd, NUMBER_OF_PARTICLES, CCD_PAIR_CAPACITY, CCD_MAX_EVENTS, ccd_storage);
+#endif
+#if RENDER_MODE == RENDER_MODE_TILED
+    tiles_init(&tiles, LCD_WIDTH, LCD_HEIGHT, tile_start, tile_items);
+#endif
     
     for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
     {
-        Particle_t* part = &particles[i];
-        part->used = 1;
-        part->color = colors[rand() % (sizeof(colors)/sizeof(colors[0]))];
-        
-        part->vx = (rand() % MAX_INITIAL_SPEED) * ((rand() % 2 == 0) ? -1 : 1);
-        part->vx = MAX(part->vx, MIN_INITIAL_SPEED) * (1.0/REFRESH_RATE);
-        part->vy = (rand() % MAX_INITIAL_SPEED) * ((rand() % 2 == 0) ? -1 : 1);
-        part->vy = MAX(part->vy, MIN_INITIAL_SPEED) * (1.0/REFRESH_RATE);
-        
-        part->ax = (rand() % MAX_FRICTION_RAND_MOD);
-        part->ax = MAX_FRICTION/REFRESH_RATE / MAX(part->ax, 1);
+        particles.color[i] = colors[rand() % (sizeof(colors)/sizeof(colors[0]))];
         
-        part->ay = (rand() % MAX_FRICTION_RAND_MOD);
-        part->ay = MAX_FRICTION/REFRESH_RATE / MAX(part->ay, 1);
+        float vx = (rand() % MAX_INITIAL_SPEED) * ((rand() % 2 == 0) ? -1 : 1);
+        particles.vx[i] = MAX(vx, MIN_INITIAL_SPEED);
+        float vy = (rand() % MAX_INITIAL_SPEED) * ((rand() % 2 == 0) ? -1 : 1);
+        particles.vy[i] = MAX(vy, MIN_INITIAL_SPEED);
         
-        part->x = CIRCLE_RADIUS + (i % MAX_PARTICLES_PER_ROW) * (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS));
-        part->y = CIRCLE_RADIUS + (i / MAX_PARTICLES_PER_ROW) * (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS));
+        float ax = (rand() % MAX_FRICTION_RAND_MOD);
+        particles.ax[i] = MAX_FRICTION / MAX(ax, 1);
         
-        double rect[] = { 
-            part->x - CIRCLE_RADIUS, part->y - CIRCLE_RADIUS, part->x + CIRCLE_RADIUS, part->y + CIRCLE_RADIUS 
-        };
+        float ay = (rand() % MAX_FRICTION_RAND_MOD);
+        particles.ay[i] = MAX_FRICTION / MAX(ay, 1);
         
-        rtree_insert(tr, rect, &part);
+        particles.x[i] = CIRCLE_RADIUS + (i % MAX_PARTICLES_PER_ROW) * (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS));
+        particles.y[i] = CIRCLE_RADIUS + (i / MAX_PARTICLES_PER_ROW) * (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS));
     }
+    
+#if BROAD_PHASE == BROAD_PHASE_RTREE
+    load_tree();
+#elif BROAD_PHASE == BROAD_PHASE_AABB_TREE
+    fill_aabb_tree();
+#endif
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
-static void check_boundaries_collision(Particle_t* part)
+#if COLLISION_MODE == COLLISION_MODE_DISCRETE
+static void integrate_particles(void)
 {
-    if(part->x > LCD_WIDTH - CIRCLE_RADIUS)
+    ProfileScope scope(PROFILE_INTEGRATE);
+    
+    particles_integrate(&particles, SIMULATION_DT, CIRCLE_RADIUS, LCD_WIDTH - CIRCLE_RADIUS, CIRCLE_RADIUS,
+                        LCD_HEIGHT - CIRCLE_RADIUS);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#endif
+
+static bool resolve_collision(int a, int b)
+{
+    if(!particles_collide(&particles, a, b, 2 * CIRCLE_RADIUS))
+        return false;
+    
+    stats.collisions++;
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Narrow phase over the collected pairs, in the order the broad phase found them
+static void resolve_pairs(void)
+{
+    ProfileScope scope(PROFILE_NARROW_PHASE);
+    
+    for(int i = 0; i < pair_count; i++)
     {
-        part->x = LCD_WIDTH - CIRCLE_RADIUS;
-        part->vx = -part->vx;
+        resolve_collision(pairs[i].a, pairs[i].b);
     }
-    else if(part->x < CIRCLE_RADIUS)
+    
+    pair_count = 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void add_pair(int a, int b)
+{
+#if COLLISION_MODE == COLLISION_MODE_CONTINUOUS
+    // Pairs the solver has no room for are left to the discrete list
+    if(ccd_add_pair(&ccd, a, b))
     {
-        part->x = CIRCLE_RADIUS;
-        part->vx = -part->vx;
+        stats.pairs++;
+        return;
     }
+#endif
+    if(pair_count == PAIR_LIST_SIZE)
+        resolve_pairs();
     
-    if(part->y > LCD_HEIGHT - CIRCLE_RADIUS)
+    pairs[pair_count].a = (uint16_t)a;
+    pairs[pair_count].b = (uint16_t)b;
+    pair_count++;
+    stats.pairs++;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+#if BROAD_PHASE == BROAD_PHASE_RTREE || BROAD_PHASE == BROAD_PHASE_AABB_TREE
+#if BROAD_PHASE == BROAD_PHASE_RTREE
+static bool collect_tree_pair(const rtree_coord_t *rect, const void *item, const rtree_coord_t *other_rect,
+                              const void *other_item, void *udata)
+{
+    add_pair(*(const int*)item, *(const int*)other_item);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void index_particles(void)
+{
+    uint32_t stuck = 0;
+    
+#if RTREE_MAINTENANCE == RTREE_MAINTENANCE_REBUILD
+    // Every particle moved, packing them all again is cheaper than moving each one inside the tree
+    load_tree();
+#else
+    for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
     {
-        part->y = LCD_HEIGHT - CIRCLE_RADIUS;
-        part->vy = -part->vy;
+        if(!move_in_tree(i))
+            stuck++;
     }
-    else if(part->y < CIRCLE_RADIUS)
+#endif
+    
+    // A load that runs out of arena leaves the tree empty, a move that does keeps the particle at its old rect
+    stats.unindexed = NUMBER_OF_PARTICLES - (uint32_t)rtree_count(tr) + stuck;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The rects are the particles themselves, so two of them overlap exactly when the particles are within a contact
+// distance on both axes, or the paths they take in continuous mode. The join reports every such pair once, the contacts
+// move the particles but the tree catches up with them at the start of the next step.
+static void find_pairs(void)
+{
+    rtree_self_join(tr, 0, collect_tree_pair, NULL);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#else
+static bool collect_box_pair(const float* box, int item, const float* other_box, int other_item, void* udata)
+{
+    add_pair(item, other_item);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Only the particles that left their fat box change the tree, the others just leave their new box in their leaf
+static void index_particles(void)
+{
+    float box[4];
+    
+    for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
     {
-        part->y = CIRCLE_RADIUS;
-        part->vy = -part->vy;
+        particle_bounds(i, box);
+        aabb_tree_move(&aabb_tree, aabb_leaves[i], box);
     }
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
-static bool check_particle_collision(const double *rect, const void *item, void *udata)
+// Same pairs as the rtree's self join: the boxes are the particles themselves, or their paths
+static void find_pairs(void)
 {
-    int** args = (int**)udata;
-    
-    Particle_t* part = (Particle_t*)*args[0];
-    list<Particle_t*>* changeList = (list<Particle_t*>*)args[1];
-    Particle_t* temp = *((Particle_t**)item);
+    aabb_tree_self_join(&aabb_tree, collect_box_pair, NULL);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#endif
 
-    if(part != temp)
+#if COLLISION_MODE == COLLISION_MODE_DISCRETE
+static void update_particles(void)
+{
+    stats.collisions = 0;
+    stats.pairs = 0;
+    
+    integrate_particles();
     {
-        PVector position(part->x, part->y);
-        PVector otherPosition(temp->x, temp->y);
-        
-        PVector distanceVect = PVector(position.x - otherPosition.x, position.y - otherPosition.y);
-        float distanceVectMag = distanceVect.mag();
-        float minDistance = 2 * CIRCLE_RADIUS;
-        if(distanceVectMag < minDistance)
-        {
-            float distanceCorrection = (minDistance - distanceVectMag) / 2.0;
-            PVector d = PVector(distanceVect.x, distanceVect.y);
-            PVector correctionVector = d.normalize().mult(distanceCorrection);
-            
-            otherPosition.sub(correctionVector);
-            position.add(correctionVector);
-            
-            distanceVect = PVector(position.x - otherPosition.x, position.y - otherPosition.y);
-            
-            float theta  = distanceVect.heading();
-            float sine = sin(theta);
-            float cosine = cos(theta);
-            
-            PVector bTemp[2];
-            
-            bTemp[1].x  = cosine * distanceVect.x + sine * distanceVect.y;
-            bTemp[1].y  = cosine * distanceVect.y - sine * distanceVect.x;
-            
-            PVector vTemp[2];
-            
-            vTemp[0].x  = cosine * part->vx + sine * part->vy;
-            vTemp[0].y  = cosine * part->vy - sine * part->vx;
-            vTemp[1].x  = cosine * temp->vx + sine * temp->vy;
-            vTemp[1].y  = cosine * temp->vy - sine * temp->vx;
-            
-            PVector vFinal[2];
-            
-            //vFinal[0].x = ((m - other.m) * vTemp[0].x + 2 * other.m * vTemp[1].x) / (m + other.m);
-            vFinal[0].x = vTemp[1].x;
-            vFinal[0].y = vTemp[0].y;
-            
-            //vFinal[1].x = ((other.m - m) * vTemp[1].x + 2 * m * vTemp[0].x) / (m + other.m);
-            vFinal[1].x = vTemp[0].x;
-            vFinal[1].y = vTemp[1].y;
-            
-            bTemp[0].x += vFinal[0].x;
-            bTemp[1].x += vFinal[1].x;
-            
-            PVector bFinal[2];
-            
-            bFinal[0].x = cosine * bTemp[0].x - sine * bTemp[0].y;
-            bFinal[0].y = cosine * bTemp[0].y + sine * bTemp[0].x;
-            bFinal[1].x = cosine * bTemp[1].x - sine * bTemp[1].y;
-            bFinal[1].y = cosine * bTemp[1].y + sine * bTemp[1].x;
-            
-            part->vx = cosine * vFinal[0].x - sine * vFinal[0].y;
-            part->vy = cosine * vFinal[0].y + sine * vFinal[0].x;
-            temp->vx = cosine * vFinal[1].x - sine * vFinal[1].y;
-            temp->vy = cosine * vFinal[1].y + sine * vFinal[1].x;
-            
-            part->x = position.x;
-            part->y = position.y;
-            
-            temp->x = otherPosition.x;
-            temp->y = otherPosition.y;
-            
-            changeList->push_front(temp);
-        }
+        ProfileScope scope(PROFILE_TREE);
+        index_particles();
     }
+    {
+        ProfileScope scope(PROFILE_BROAD_PHASE);
+        find_pairs();
+    }
+    resolve_pairs();
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#else
+static void update_particles(void)
+{
+    stats.collisions = 0;
+    stats.pairs = 0;
     
+    // Friction changes the velocities up front, the solver then moves the particles along them
+    {
+        ProfileScope scope(PROFILE_INTEGRATE);
+        particles_damp(&particles, SIMULATION_DT);
+    }
+    
+    // The boxes cover the whole path of every particle over the step, so the pairs are the particles that may meet
+    // anywhere along the way rather than those touching where they stand
+    {
+        ProfileScope scope(PROFILE_TREE);
+        index_particles();
+    }
+    {
+        ProfileScope scope(PROFILE_BROAD_PHASE);
+        ccd_begin(&ccd);
+        find_pairs();
+    }
+    {
+        ProfileScope scope(PROFILE_NARROW_PHASE);
+        stats.collisions += ccd_solve(&ccd, &particles, SIMULATION_DT, 2 * CIRCLE_RADIUS, CIRCLE_RADIUS,
+                                      LCD_WIDTH - CIRCLE_RADIUS, CIRCLE_RADIUS, LCD_HEIGHT - CIRCLE_RADIUS);
+    }
+    resolve_pairs();
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#endif
+#else
+static bool collect_pair(int a, int b, void* udata)
+{
+    add_pair(a, b);
     return true;
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
+#if BROAD_PHASE == BROAD_PHASE_GRID
+
 static void update_particles(void)
 {
+    stats.collisions = 0;
+    stats.pairs = 0;
+    
+    integrate_particles();
+    
+    // The grid is rebuilt from scratch, the pairs come out once each so every contact is resolved a single time
+    {
+        ProfileScope scope(PROFILE_TREE);
+        grid_build(&grid, particles.x, particles.y, sizeof(float), NUMBER_OF_PARTICLES);
+    }
+    {
+        ProfileScope scope(PROFILE_BROAD_PHASE);
+        grid_pairs(&grid, collect_pair, NULL);
+    }
+    resolve_pairs();
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#elif BROAD_PHASE == BROAD_PHASE_SAP
+static void update_particles(void)
+{
+    stats.collisions = 0;
+    stats.pairs = 0;
+    
+    integrate_particles();
+    
+    // The particles moved a few pixels at most, so the ends are nearly sorted already. The screen is taller than wide,
+    // sweeping down it leaves fewer intervals overlapping.
+    {
+        ProfileScope scope(PROFILE_TREE);
+        sap_update(&sap, particles.y, particles.x, sizeof(float), NUMBER_OF_PARTICLES);
+    }
+    {
+        ProfileScope scope(PROFILE_BROAD_PHASE);
+        sap_pairs(&sap, collect_pair, NULL);
+    }
+    resolve_pairs();
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#endif
+#endif
+
+static void publish_snapshot(void)
+{
+    Snapshot_t* frame = snapshots.back();
+    
     for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
     {
-        Particle_t* part = (Particle_t*)&particles[i];
-        part->x += part->vx;
-        part->y += part->vy;
-        check_boundaries_collision(part);
-        
-        double rect[] = { 
-            part->x - 2 * CIRCLE_RADIUS, 
-            part->y - 2 * CIRCLE_RADIUS, 
-            part->x + 2 * CIRCLE_RADIUS, 
-            part->y + 2 * CIRCLE_RADIUS 
-        };
-        
-        list<Particle_t*> changeList;
-        changeList.push_front(part);
-        
-        int* args[] = {
-            (int*)&part,
-            (int*)&changeList
-        };
+        frame->x[i] = (int16_t)particles.x[i];
+        frame->y[i] = (int16_t)particles.y[i];
+        frame->color[i] = particles.color[i];
+    }
+    
+    frame->step = step_count++;
+    frame->collisions = stats.collisions;
+    frame->pairs = stats.pairs;
+    for(int phase = 0; phase < PHYSICS_PHASES; phase++)
+    {
+        frame->cycles[phase] = profiler_current((ProfilePhase_t)phase);
+    }
+    snapshots.publish();
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Records where the particles are drawn into the buffer this time. A particle that moved dirties where the buffer shows
+// it and where it is now, one rect covers both.
+static void track_dirty(int buffer, const Snapshot_t* frame)
+{
+    int16_t* x = drawn_x[buffer];
+    int16_t* y = drawn_y[buffer];
+    
+    dirty_reset(&dirty, LCD_WIDTH, LCD_HEIGHT);
+    for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
+    {
+        int16_t new_x = frame->x[i];
+        int16_t new_y = frame->y[i];
         
-        rtree_search(tr, rect, check_particle_collision, &args);
+        if(new_x == x[i] && new_y == y[i])
+            continue;
         
-        for(list<Particle_t*>::iterator it = changeList.begin(); it != changeList.end(); it++)
+        if(drawn_valid[buffer])
+            dirty_add(&dirty, MIN(x[i], new_x) - CIRCLE_RADIUS, MIN(y[i], new_y) - CIRCLE_RADIUS,
+                      MAX(x[i], new_x) + CIRCLE_RADIUS + 1, MAX(y[i], new_y) + CIRCLE_RADIUS + 1);
+        x[i] = new_x;
+        y[i] = new_y;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void draw_all_particles(int buffer, const Snapshot_t* frame)
+{
+    lcd_dma2d_clear(LCD_COLOR_BLACK);
+    
+    if(circle_sprite)
+    {
+        // One blend per particle, queued behind the clear
+        for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
         {
-            Particle_t* partTemp = (Particle_t*)*it;
-            double rect[] = { 
-                partTemp->x - CIRCLE_RADIUS, partTemp->y - CIRCLE_RADIUS, partTemp->x + CIRCLE_RADIUS, partTemp->y + CIRCLE_RADIUS 
-            };
-            rtree_delete(tr, rect, &partTemp);
-            rtree_insert(tr, rect, &partTemp);
+            sprite_draw(circle_sprite, drawn_x[buffer][i], drawn_y[buffer][i], frame->color[i]);
         }
+        return;
+    }
+    
+    // No room for the sprite, the CPU draws the outlines once the clear is done
+    lcd_dma2d_wait();
+    for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
+    {
+        LCD_SetTextColor(frame->color[i]);
+        LCD_DrawCircle((uint16_t)drawn_x[buffer][i], (uint16_t)drawn_y[buffer][i], CIRCLE_RADIUS);
+    }  
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+#if RENDER_MODE == RENDER_MODE_TILED
+static bool tile_dirty(int tile)
+{
+    int left, top, right, bottom;
+    
+    tiles_bounds(&tiles, tile, &left, &top, &right, &bottom);
+    for(int r = 0; r < dirty.count; r++)
+    {
+        if(dirty_overlaps(&dirty.rects[r], left, top, right, bottom))
+            return true;
+    }
+    return false;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Only the tiles the dirty rects reach are rendered again, every one of them in full
+static void draw_tiles(int buffer, const Snapshot_t* frame, bool full)
+{
+    tiles_bin(&tiles, drawn_x[buffer], drawn_y[buffer], NUMBER_OF_PARTICLES, CIRCLE_RADIUS);
+    
+    for(int tile = 0; tile < TILE_COUNT(LCD_WIDTH, LCD_HEIGHT); tile++)
+    {
+        if(full || tile_dirty(tile))
+            tiles_draw(&tiles, tile, circle_sprite, drawn_x[buffer], drawn_y[buffer], frame->color, LCD_COLOR_BLACK);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#else
+// Each rect is cleared and everything reaching into it is blended again in the same order as a full redraw, clipped so
+// the pixels outside, which are already right, are not blended twice
+static void draw_dirty_rects(int buffer, const Snapshot_t* frame)
+{
+    int16_t* x = drawn_x[buffer];
+    int16_t* y = drawn_y[buffer];
+    
+    for(int r = 0; r < dirty.count; r++)
+    {
+        const DirtyRect_t* rect = &dirty.rects[r];
         
-        part->vx *= (1.0 - part->ax);
-        part->vy *= (1.0 - part->ay);
+        lcd_dma2d_fill(rect->left, rect->top, rect->right - rect->left, rect->bottom - rect->top, LCD_COLOR_BLACK);
+        for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
+        {
+            if(dirty_overlaps(rect, x[i] - CIRCLE_RADIUS, y[i] - CIRCLE_RADIUS, x[i] + CIRCLE_RADIUS + 1,
+                              y[i] + CIRCLE_RADIUS + 1))
+            {
+                sprite_draw_clipped(circle_sprite, x[i], y[i], frame->color[i], rect->left, rect->top, rect->right,
+                                    rect->bottom);
+            }
+        }
     }
 }
 // ---------------------------------------------------------------------------------------------------------------------
+#endif
 
-static void draw_particles(bool clear)
+static void draw_particles(int buffer, const Snapshot_t* frame)
 {
-    for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
+    bool full = !drawn_valid[buffer];
+    
     {
-        Particle_t* part = (Particle_t*)&particles[i];
-        if(clear)
-            LCD_SetTextColor(LCD_COLOR_BLACK);
-        else
-            LCD_SetTextColor(part->color);
-        LCD_DrawCircle((uint16_t)part->x, (uint16_t)part->y, CIRCLE_RADIUS);
-    }  
+        ProfileScope scope(PROFILE_ERASE);
+        track_dirty(buffer, frame);
+    }
+    
+    ProfileScope scope(PROFILE_DRAW);
+    // Outlines drawn by the CPU cannot be clipped, so without the sprite every frame is drawn in full
+    if(!circle_sprite)
+    {
+        draw_all_particles(buffer, frame);
+        return;
+    }
+    
+#if RENDER_MODE == RENDER_MODE_TILED
+    draw_tiles(buffer, frame, full);
+#else
+    if(full)
+        draw_all_particles(buffer, frame);
+    else
+        draw_dirty_rects(buffer, frame);
+#endif
+    drawn_valid[buffer] = true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+#if SHOW_HUD
+static void reset_hud_window(uint32_t now, uint32_t step)
+{
+    hud_window.start = now;
+    hud_window.frames = 0;
+    hud_window.last_step = step;
+    hud_window.steps = 0;
+    hud_window.collisions = 0;
+    hud_window.pairs = 0;
+    for(int phase = 0; phase < PHYSICS_PHASES; phase++)
+    {
+        hud_window.cycles[phase] = 0;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Hundredths of a millisecond per frame
+static uint32_t centi_ms(uint32_t cycles, uint32_t frames)
+{
+    return frames ? (uint32_t)((uint64_t)cycles * 100000 / ((uint64_t)cycle_counter_rate() * frames)) : 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Only redrawn a few times a second, on a layer of its own so the particles underneath are left alone. The physics
+// phases are averaged over the steps seen since the last refresh, the render phases over the profiler's history.
+static void draw_hud(const Snapshot_t* frame)
+{
+    uint32_t now = cycle_counter_read();
+    uint32_t elapsed = now - hud_window.start;
+    uint32_t times[PROFILE_PHASES];
+    
+    hud_window.frames++;
+    if(frame->step != hud_window.last_step)
+    {
+        hud_window.last_step = frame->step;
+        hud_window.steps++;
+        hud_window.collisions += frame->collisions;
+        hud_window.pairs += frame->pairs;
+        for(int phase = 0; phase < PHYSICS_PHASES; phase++)
+        {
+            hud_window.cycles[phase] += frame->cycles[phase];
+        }
+    }
+    
+    if(elapsed < cycle_counter_rate() / HUD_REFRESH_RATE)
+        return;
+    
+    for(int phase = 0; phase < PROFILE_PHASES; phase++)
+    {
+        ProfileStats_t phase_stats;
+        
+        if(phase < PHYSICS_PHASES)
+        {
+            times[phase] = centi_ms(hud_window.cycles[phase], hud_window.steps);
+            continue;
+        }
+        profiler_stats((ProfilePhase_t)phase, &phase_stats);
+        times[phase] = centi_ms(phase_stats.avg, 1);
+    }
+    uint32_t deci_fps = (uint32_t)((uint64_t)hud_window.frames * 10 * cycle_counter_rate() / elapsed);
+    
+    hud_begin();
+    hud_printf(0, 0, "fps %3u.%u cpu %3u%% heap %5u", (unsigned)(deci_fps / 10), (unsigned)(deci_fps % 10),
+               (unsigned)cpu_usage(), (unsigned)alloc_guard_peak_bytes());
+    if(hud_window.steps)
+        hud_printf(0, 1, "contacts %u pairs %u", (unsigned)(hud_window.collisions / hud_window.steps),
+                   (unsigned)(hud_window.pairs / hud_window.steps));
+    for(int phase = 0; phase < PROFILE_PHASES; phase++)
+    {
+        hud_printf((uint16_t)((phase % 2) * HUD_PHASE_COLUMNS), (uint16_t)(2 + phase / 2), "%-9s%2u.%02u",
+                   profiler_phase_name((ProfilePhase_t)phase), (unsigned)(times[phase] / 100),
+                   (unsigned)(times[phase] % 100));
+    }
+    hud_end();
+    
+    reset_hud_window(now, frame->step);
 }
 // ---------------------------------------------------------------------------------------------------------------------
+#endif
 
 // ---------------------------------------------------------------------------------------------------------------------
 // Public functions
 // ---------------------------------------------------------------------------------------------------------------------
 void app_init(void)
 {
+    profiler_init();
     initialize_particles();
-    LCD_Clear(LCD_COLOR_BLACK);
+    publish_snapshot();
+    circle_sprite = sprite_circle(CIRCLE_RADIUS);
+    lcd_dma2d_init();
+#if SHOW_HUD
+    hud_init(HUD_LINES);
+    reset_hud_window(cycle_counter_read(), 0);
+#endif
+    display_init(LCD_COLOR_BLACK);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
 void app_update(void)
 {
-    draw_particles(true);
-    
+    app_simulate();
+    app_render();
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void app_simulate(void)
+{
     update_particles();
-    draw_particles(false);
-    delayMiliSecs(REFRESH_PERIOD);
+    publish_snapshot();
+    profiler_end_frame(PROFILE_INTEGRATE, PROFILE_NARROW_PHASE);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void app_render(void)
+{
+    const Snapshot_t* frame = snapshots.latest();
+    int buffer;
+    
+    // The buffer drawn here is off screen until display_present(), waiting for it paces the loop to the display
+    {
+        ProfileScope scope(PROFILE_SLEEP);
+        buffer = display_begin_frame();
+    }
+    
+    draw_particles(buffer, frame);
+#if SHOW_HUD
+    {
+        ProfileScope scope(PROFILE_DRAW);
+        draw_hud(frame);
+    }
+#endif
+    {
+        ProfileScope scope(PROFILE_SLEEP);
+        lcd_dma2d_wait();
+    }
+    display_present();
+    profiler_end_frame(PROFILE_ERASE, PROFILE_SLEEP);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+const AppStats_t* app_get_stats(void)
+{
+    return &stats;
 }
 // ---------------------------------------------------------------------------------------------------------------------
@@ -2,8 +2,10 @@
 // Includes
 // ---------------------------------------------------------------------------------------------------------------------
 
-#include "app.hpp"
+#include "app.h"
 #include "vector.hpp"
+#include "dirty.h"
+#include "lcd_dma2d.h"
 
 extern "C" {
 #include "math.h"
@@ -17,9 +19,15 @@ extern "C" {
 #define LCD_WIDTH                       240
 #define LCD_HEIGHT                      320
 
+#ifndef CIRCLE_RADIUS
 #define CIRCLE_RADIUS                   10
+#endif
+#ifndef NUMBER_OF_PARTICLES
 #define NUMBER_OF_PARTICLES             20
+#endif
+#ifndef INITIAL_DIST_BETWEEN_PARTS
 #define INITIAL_DIST_BETWEEN_PARTS      8
+#endif
 #define MAX_PARTICLES_PER_ROW           (LCD_WIDTH / (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS)))
 #define MAX_PARTICLES_PER_COL           (LCD_HEIGHT / (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS)))
 #define MAX_PARTICLES                   (                                                                              \
@@ -33,8 +41,7 @@ extern "C" {
                                         )
   
 #define MAX_FRICTION                    0.1f
-#define REFRESH_RATE                    60 //Hz
-#define REFRESH_PERIOD                  ((uint32_t)((1.0/REFRESH_RATE) * 1000))
+#define SIMULATION_DT                   (1.0f / APP_SIMULATION_RATE)
 #define MIN_INITIAL_SPEED               150
 #define MAX_INITIAL_SPEED               200 
 
@@ -81,6 +88,8 @@ static const uint16_t colors[] =
 // Private variables
 // ---------------------------------------------------------------------------------------------------------------------
 static Bucket_t buckets[MAX_BUCKETS_PER_ROW][MAX_BUCKETS_PER_COL];
+static AppStats_t stats;
+static DirtyRegion_t dirty;
 
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -102,18 +111,25 @@ static Bucket_t* getBucketId(Particle_t* part)
 
 static void initialize_particles(void)
 {
+#ifdef APP_RANDOM_SEED
+    srand(APP_RANDOM_SEED);
+#else
     srand(time(0));
+#endif
     memset(&buckets, 0, sizeof(buckets));
     
     for(int i = 0; i < NUMBER_OF_PARTICLES; i++)
     {
         Particle_t part;
         part.used = 1;
+        // Not on screen yet
+        part.drawn_x = -1;
+        part.drawn_y = -1;
         part.color = colors[rand() % (sizeof(colors)/sizeof(colors[0]))];
         part.vx = (rand() % MAX_INITIAL_SPEED) * ((rand() % 2 == 0) ? -1 : 1);
-        part.vx = MAX(part.vx, MIN_INITIAL_SPEED) * (1.0/REFRESH_RATE);
+        part.vx = MAX(part.vx, MIN_INITIAL_SPEED);
         part.vy = (rand() % MAX_INITIAL_SPEED) * ((rand() % 2 == 0) ? -1 : 1);
-        part.vy = MAX(part.vy, MIN_INITIAL_SPEED) * (1.0/REFRESH_RATE);
+        part.vy = MAX(part.vy, MIN_INITIAL_SPEED);
         part.x = CIRCLE_RADIUS + (i % MAX_PARTICLES_PER_ROW) * (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS));
         part.y = CIRCLE_RADIUS + (i / MAX_PARTICLES_PER_ROW) * (2 * (CIRCLE_RADIUS + INITIAL_DIST_BETWEEN_PARTS));
         
@@ -149,96 +165,6 @@ static void check_boundaries_collision(Particle_t* part)
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
-static int check_particle_collision(int id, void* arg)
-{
-    //int* args[] = { (int*)part, (int*)&temp_list };
-    
-    Particle_t* temp;// = &particles[id];
-    int* args = (int*)arg;
-    Particle_t* part = (Particle_t*)args[0];
-    int* temp_list = (int*)args[1];
-    int* temp_list_cnt = (int*)args[2];
-    
-    if(part != temp)
-    {
-        PVector position(part->x, part->y);
-        PVector otherPosition(temp->x, temp->y);
-        
-        PVector distanceVect = PVector(position.x - otherPosition.x, position.y - otherPosition.y);
-        float distanceVectMag = distanceVect.mag();
-        float minDistance = 2 * CIRCLE_RADIUS;
-        if(distanceVectMag < minDistance)
-        {
-            float distanceCorrection = (minDistance - distanceVectMag) / 2.0;
-            PVector d = PVector(distanceVect.x, distanceVect.y);
-            PVector correctionVector = d.normalize().mult(distanceCorrection);
-            
-            otherPosition.sub(correctionVector);
-            position.add(correctionVector);
-            
-            distanceVect = PVector(position.x - otherPosition.x, position.y - otherPosition.y);
-            
-            float theta  = distanceVect.heading();
-            float sine = sin(theta);
-            float cosine = cos(theta);
-            
-            PVector bTemp[2];
-            
-            bTemp[1].x  = cosine * distanceVect.x + sine * distanceVect.y;
-            bTemp[1].y  = cosine * distanceVect.y - sine * distanceVect.x;
-            
-            PVector vTemp[2];
-            
-            vTemp[0].x  = cosine * part->vx + sine * part->vy;
-            vTemp[0].y  = cosine * part->vy - sine * part->vx;
-            vTemp[1].x  = cosine * temp->vx + sine * temp->vy;
-            vTemp[1].y  = cosine * temp->vy - sine * temp->vx;
-            
-            PVector vFinal[2];
-            
-            //vFinal[0].x = ((m - other.m) * vTemp[0].x + 2 * other.m * vTemp[1].x) / (m + other.m);
-            vFinal[0].x = vTemp[1].x;
-            vFinal[0].y = vTemp[0].y;
-            
-            //vFinal[1].x = ((other.m - m) * vTemp[1].x + 2 * m * vTemp[0].x) / (m + other.m);
-            vFinal[1].x = vTemp[0].x;
-            vFinal[1].y = vTemp[1].y;
-            
-            bTemp[0].x += vFinal[0].x;
-            bTemp[1].x += vFinal[1].x;
-            
-            PVector bFinal[2];
-            
-            bFinal[0].x = cosine * bTemp[0].x - sine * bTemp[0].y;
-            bFinal[0].y = cosine * bTemp[0].y + sine * bTemp[0].x;
-            bFinal[1].x = cosine * bTemp[1].x - sine * bTemp[1].y;
-            bFinal[1].y = cosine * bTemp[1].y + sine * bTemp[1].x;
-            
-            part->vx = cosine * vFinal[0].x - sine * vFinal[0].y;
-            part->vy = cosine * vFinal[0].y + sine * vFinal[0].x;
-            temp->vx = cosine * vFinal[1].x - sine * vFinal[1].y;
-            temp->vy = cosine * vFinal[1].y + sine * vFinal[1].x;
-            
-            part->x = position.x;
-            part->y = position.y;
-            
-            temp->x = otherPosition.x;
-            temp->y = otherPosition.y;
-            
-            temp_list[*temp_list_cnt] = id;
-            (*temp_list_cnt)++;
-        }
-    }
-    else
-    {
-        static int a = 0;
-        a++;
-    }
-    
-    return 1;
-}
-// ---------------------------------------------------------------------------------------------------------------------
-
 static void update_particles(void)
 {
     for(int i = 0; i < MAX_BUCKETS_PER_ROW; i++)
@@ -250,8 +176,8 @@ static void update_particles(void)
                 Particle_t* part = &buckets[i][j].setp[k];
                 if(part->used)
                 {
-                    part->x += part->vx;
-                    part->y += part->vy;
+                    part->x += part->vx * SIMULATION_DT;
+                    part->y += part->vy * SIMULATION_DT;
                     check_boundaries_collision(part);
                 }
             }
@@ -278,10 +204,56 @@ static void update_particles(void)
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
+static bool is_dirty(const Particle_t* part)
+{
+    for(int r = 0; r < dirty.count; r++)
+    {
+        if(dirty_overlaps(&dirty.rects[r], part->drawn_x - CIRCLE_RADIUS, part->drawn_y - CIRCLE_RADIUS,
+                          part->drawn_x + CIRCLE_RADIUS + 1, part->drawn_y + CIRCLE_RADIUS + 1))
+            return true;
+    }
+    return false;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Without clear only the rects the moving particles dirtied are cleared, and everything reaching into them is drawn
+// again. The outlines are not clipped, so where a redrawn particle overlaps one that was left alone the one drawn last
+// may change, as it could with every full redraw.
 static void draw_particles(bool clear)
 {
+    dirty_reset(&dirty, LCD_WIDTH, LCD_HEIGHT);
+    
+    for(int i = 0; i < MAX_BUCKETS_PER_ROW; i++)
+    {
+        for(int j = 0; j < MAX_BUCKETS_PER_COL; j++)
+        {
+            for(int k = 0; k < buckets[i][j].count; k++)
+            {
+                Particle_t* part = &buckets[i][j].setp[k];
+                int16_t new_x = (int16_t)part->x;
+                int16_t new_y = (int16_t)part->y;
+                
+                if(!part->used || (new_x == part->drawn_x && new_y == part->drawn_y))
+                    continue;
+                
+                if(!clear)
+                    dirty_add(&dirty, MIN(part->drawn_x, new_x) - CIRCLE_RADIUS,
+                              MIN(part->drawn_y, new_y) - CIRCLE_RADIUS, MAX(part->drawn_x, new_x) + CIRCLE_RADIUS + 1,
+                              MAX(part->drawn_y, new_y) + CIRCLE_RADIUS + 1);
+                part->drawn_x = new_x;
+                part->drawn_y = new_y;
+            }
+        }
+    }
+    
     if(clear)
-        LCD_Clear(LCD_COLOR_BLACK);
+        lcd_dma2d_clear(LCD_COLOR_BLACK);
+    for(int r = 0; r < dirty.count; r++)
+    {
+        const DirtyRect_t* rect = &dirty.rects[r];
+        lcd_dma2d_fill(rect->left, rect->top, rect->right - rect->left, rect->bottom - rect->top, LCD_COLOR_BLACK);
+    }
+    lcd_dma2d_wait();
     
     for(int i = 0; i < MAX_BUCKETS_PER_ROW; i++)
     {
@@ -290,10 +262,10 @@ static void draw_particles(bool clear)
             for(int k = 0; k < buckets[i][j].count; k++)
             {
                 Particle_t* part = &buckets[i][j].setp[k];
-                if(part->used)
+                if(part->used && (clear || is_dirty(part)))
                 {
                     LCD_SetTextColor(part->color);
-                    LCD_DrawCircle((uint16_t)part->x, (uint16_t)part->y, CIRCLE_RADIUS);
+                    LCD_DrawCircle((uint16_t)part->drawn_x, (uint16_t)part->drawn_y, CIRCLE_RADIUS);
                 }
             }
         }
@@ -313,8 +285,27 @@ void app_init(void)
 
 void app_update(void)
 {
-    draw_particles(true);
+    app_render();
     update_particles();
-    Delay(REFRESH_PERIOD);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The bucket path draws straight from the simulation state, it must not run at the same time as app_simulate()
+void app_render(void)
+{
+    draw_particles(false);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void app_simulate(void)
+{
+    // The bucket path does not resolve contacts yet, so the stats stay at zero
+    update_particles();
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+const AppStats_t* app_get_stats(void)
+{
+    return &stats;
 }
 // ---------------------------------------------------------------------------------------------------------------------
@@ -11,6 +11,9 @@
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 
+// Every app_simulate() advances the simulation by 1 / APP_SIMULATION_RATE seconds, however often it is called
+#define APP_SIMULATION_RATE     60 //Hz
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Typedefs
 // ---------------------------------------------------------------------------------------------------------------------
@@ -18,6 +21,8 @@ typedef struct Particle_s
 {
     uint16_t used;
     uint16_t color;
+    int16_t drawn_x;            // where the particle is on screen, the dirty rects are worked out from it
+    int16_t drawn_y;
     float x;
     float y;
     float vx;
@@ -25,14 +30,26 @@ typedef struct Particle_s
     float ax;
     float ay;
 }Particle_t;
+
+typedef struct AppStats_s 
+{
+    uint32_t collisions;        // contacts resolved by the last simulation step
+    uint32_t pairs;             // candidate pairs its broad phase found
+    uint32_t unindexed;         // particles its broad phase index lost or could not move, for want of room
+}AppStats_t;
 // ---------------------------------------------------------------------------------------------------------------------
 
 
 // ---------------------------------------------------------------------------------------------------------------------
 // Exported functions
 // ---------------------------------------------------------------------------------------------------------------------
+// app_simulate() steps the simulation and publishes a snapshot of it, app_render() draws the latest snapshot and may run
+// in a task of its own. app_update() is one of each, back to back.
 void app_init(void);
 void app_update(void);
+void app_simulate(void);
+void app_render(void);
+const AppStats_t* app_get_stats(void);
 // ---------------------------------------------------------------------------------------------------------------------
 
 #endif /* __APP_H */
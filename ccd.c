@@ -0,0 +1,321 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "ccd.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define NEVER                           FLT_MAX
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// What ccd_solve() was called with
+typedef struct Step_s
+{
+    ParticleStore_t* store;
+    float min_distance;
+    float min_x;
+    float max_x;
+    float min_y;
+    float max_y;
+}Step_t;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static void advance(Ccd_t* ccd, ParticleStore_t* store, int i, float t)
+{
+    float elapsed = t - ccd->time[i];
+
+    store->x[i] += store->vx[i] * elapsed;
+    store->y[i] += store->vy[i] * elapsed;
+    ccd->time[i] = t;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Time until a particle on one axis reaches the wall it is heading for, at once if it is already past it
+static float axis_impact(float pos, float vel, float lo, float hi)
+{
+    if(vel > 0.0f)
+        return (pos >= hi) ? 0.0f : (hi - pos) / vel;
+    if(vel < 0.0f)
+        return (pos <= lo) ? 0.0f : (lo - pos) / vel;
+    return NEVER;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static float wall_impact(const Ccd_t* ccd, const Step_t* step, int i)
+{
+    const ParticleStore_t* store = step->store;
+    float tx = axis_impact(store->x[i], store->vx[i], step->min_x, step->max_x);
+    float ty = axis_impact(store->y[i], store->vy[i], step->min_y, step->max_y);
+    float t = (tx < ty) ? tx : ty;
+
+    return (t == NEVER) ? NEVER : ccd->time[i] + t;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// First time the two centres are min_distance apart, solved from where both are at the later of their times:
+// |d + w t|^2 = min_distance^2 with d the offset and w the relative velocity. Only an approaching pair can touch, and
+// one that already overlaps touches right away.
+static float pair_impact(const Ccd_t* ccd, const Step_t* step, int pair)
+{
+    const ParticleStore_t* store = step->store;
+    int a = ccd->pairs[pair].a;
+    int b = ccd->pairs[pair].b;
+    float t0 = (ccd->time[a] > ccd->time[b]) ? ccd->time[a] : ccd->time[b];
+    float dx = (store->x[a] + store->vx[a] * (t0 - ccd->time[a])) - (store->x[b] + store->vx[b] * (t0 - ccd->time[b]));
+    float dy = (store->y[a] + store->vy[a] * (t0 - ccd->time[a])) - (store->y[b] + store->vy[b] * (t0 - ccd->time[b]));
+    float wx = store->vx[a] - store->vx[b];
+    float wy = store->vy[a] - store->vy[b];
+    float approach = dx * wx + dy * wy;
+    float gap = dx * dx + dy * dy - step->min_distance * step->min_distance;
+    float discriminant;
+
+    if(approach >= 0.0f)
+        return NEVER;
+    if(gap <= 0.0f)
+        return t0;
+
+    discriminant = approach * approach - (wx * wx + wy * wy) * gap;
+    if(discriminant < 0.0f)
+        return NEVER;
+
+    // The smaller root, written so that nothing cancels when the paths only graze
+    return t0 + gap / (-approach + sqrtf(discriminant));
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void place(Ccd_t* ccd, int slot, int entry)
+{
+    ccd->heap[slot] = (uint16_t)entry;
+    ccd->heap_slot[entry] = (uint16_t)slot;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void sift_up(Ccd_t* ccd, int slot)
+{
+    int entry = ccd->heap[slot];
+
+    while(slot > 0)
+    {
+        int parent = (slot - 1) / 2;
+
+        if(ccd->impact[ccd->heap[parent]] <= ccd->impact[entry])
+            break;
+        place(ccd, slot, ccd->heap[parent]);
+        slot = parent;
+    }
+    place(ccd, slot, entry);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void sift_down(Ccd_t* ccd, int slot)
+{
+    int size = ccd->count + ccd->pair_count;
+    int entry = ccd->heap[slot];
+
+    for(;;)
+    {
+        int child = 2 * slot + 1;
+
+        if(child >= size)
+            break;
+        if(child + 1 < size && ccd->impact[ccd->heap[child + 1]] < ccd->impact[ccd->heap[child]])
+            child++;
+        if(ccd->impact[entry] <= ccd->impact[ccd->heap[child]])
+            break;
+        place(ccd, slot, ccd->heap[child]);
+        slot = child;
+    }
+    place(ccd, slot, entry);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void reschedule(Ccd_t* ccd, int entry, float impact)
+{
+    float previous = ccd->impact[entry];
+
+    ccd->impact[entry] = impact;
+    if(impact < previous)
+        sift_up(ccd, ccd->heap_slot[entry]);
+    else
+        sift_down(ccd, ccd->heap_slot[entry]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The particle's velocity changed, so do all the contacts it is part of
+static void retime(Ccd_t* ccd, const Step_t* step, int i)
+{
+    reschedule(ccd, i, wall_impact(ccd, step, i));
+    for(int k = ccd->adjacency_start[i]; k < ccd->adjacency_start[i + 1]; k++)
+    {
+        reschedule(ccd, ccd->count + ccd->adjacency[k], pair_impact(ccd, step, ccd->adjacency[k]));
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Reflects off the wall the particle reaches at t, or off both in a corner
+static void bounce_wall(Ccd_t* ccd, const Step_t* step, int i, float t)
+{
+    ParticleStore_t* store = step->store;
+    float tx, ty;
+
+    advance(ccd, store, i, t);
+    tx = axis_impact(store->x[i], store->vx[i], step->min_x, step->max_x);
+    ty = axis_impact(store->y[i], store->vy[i], step->min_y, step->max_y);
+
+    if(tx <= ty)
+    {
+        store->x[i] = (store->vx[i] > 0.0f) ? step->max_x : step->min_x;
+        store->vx[i] = -store->vx[i];
+    }
+    if(ty <= tx)
+    {
+        store->y[i] = (store->vy[i] > 0.0f) ? step->max_y : step->min_y;
+        store->vy[i] = -store->vy[i];
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Pairs of every particle, by counting sort like grid_build()
+static void build_adjacency(Ccd_t* ccd)
+{
+    uint16_t* start = ccd->adjacency_start;
+
+    memset(start, 0, (ccd->count + 1) * sizeof(uint16_t));
+    for(int p = 0; p < ccd->pair_count; p++)
+    {
+        start[ccd->pairs[p].a]++;
+        start[ccd->pairs[p].b]++;
+    }
+    for(int i = 1; i <= ccd->count; i++)
+    {
+        start[i] += start[i - 1];
+    }
+    for(int p = ccd->pair_count - 1; p >= 0; p--)
+    {
+        ccd->adjacency[--start[ccd->pairs[p].a]] = (uint16_t)p;
+        ccd->adjacency[--start[ccd->pairs[p].b]] = (uint16_t)p;
+    }
+    start[ccd->count] = (uint16_t)(2 * ccd->pair_count);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void ccd_init(Ccd_t* ccd, int count, int pair_capacity, int max_events, uint32_t* storage)
+{
+    int entries = count + pair_capacity;
+    uint16_t* indices = (uint16_t*)(storage + count + entries + pair_capacity);
+
+    ccd->count = count;
+    ccd->pair_capacity = pair_capacity;
+    ccd->pair_count = 0;
+    ccd->max_events = max_events;
+    ccd->time = (float*)storage;
+    ccd->impact = (float*)storage + count;
+    ccd->pairs = (CcdPair_t*)(storage + count + entries);
+    ccd->heap = indices;
+    ccd->heap_slot = indices + entries;
+    ccd->adjacency_start = indices + 2 * entries;
+    ccd->adjacency = ccd->adjacency_start + count + 1;
+    ccd->events = 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void ccd_begin(Ccd_t* ccd)
+{
+    ccd->pair_count = 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool ccd_add_pair(Ccd_t* ccd, int a, int b)
+{
+    if(ccd->pair_count == ccd->pair_capacity)
+        return false;
+
+    ccd->pairs[ccd->pair_count].a = (uint16_t)a;
+    ccd->pairs[ccd->pair_count].b = (uint16_t)b;
+    ccd->pair_count++;
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+int ccd_solve(Ccd_t* ccd, ParticleStore_t* store, float dt, float min_distance, float min_x, float max_x, float min_y,
+              float max_y)
+{
+    Step_t step = { store, min_distance, min_x, max_x, min_y, max_y };
+    int entries = ccd->count + ccd->pair_count;
+    int contacts = 0;
+
+    build_adjacency(ccd);
+    for(int i = 0; i < ccd->count; i++)
+    {
+        ccd->time[i] = 0.0f;
+    }
+    for(int e = 0; e < entries; e++)
+    {
+        ccd->impact[e] = (e < ccd->count) ? wall_impact(ccd, &step, e) : pair_impact(ccd, &step, e - ccd->count);
+        place(ccd, e, e);
+    }
+    for(int slot = entries / 2 - 1; slot >= 0; slot--)
+    {
+        sift_down(ccd, slot);
+    }
+
+    // Earliest contact first, every one of them may change which comes next
+    for(ccd->events = 0; ccd->events < (uint32_t)ccd->max_events; ccd->events++)
+    {
+        int entry = ccd->heap[0];
+        float t = ccd->impact[entry];
+
+        if(t > dt)
+            break;
+
+        if(entry < ccd->count)
+        {
+            bounce_wall(ccd, &step, entry, t);
+            retime(ccd, &step, entry);
+        }
+        else
+        {
+            int a = ccd->pairs[entry - ccd->count].a;
+            int b = ccd->pairs[entry - ccd->count].b;
+
+            advance(ccd, store, a, t);
+            advance(ccd, store, b, t);
+            if(particles_bounce(store, a, b, min_distance))
+                contacts++;
+            retime(ccd, &step, a);
+            retime(ccd, &step, b);
+        }
+    }
+
+    // The rest of the step, kept inside the walls in case the contacts ran out before it did
+    for(int i = 0; i < ccd->count; i++)
+    {
+        advance(ccd, store, i, dt);
+        if(store->x[i] < min_x || store->x[i] > max_x)
+        {
+            store->x[i] = (store->x[i] < min_x) ? min_x : max_x;
+            store->vx[i] = -store->vx[i];
+        }
+        if(store->y[i] < min_y || store->y[i] > max_y)
+        {
+            store->y[i] = (store->y[i] < min_y) ? min_y : max_y;
+            store->vy[i] = -store->vy[i];
+        }
+    }
+
+    return contacts;
+}
+// ---------------------------------------------------------------------------------------------------------------------
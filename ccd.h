@@ -0,0 +1,73 @@
+#ifndef __CCD_H
+#define __CCD_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdbool.h>
+#include "particles.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Words of storage for a number of particles and of candidate pairs, see ccd_init()
+#define CCD_WORDS(count, pairs)         (3 * (count) + 3 * (pairs) + ((count) + 2 * (pairs) + 2) / 2)
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+typedef struct CcdPair_s
+{
+    uint16_t a;
+    uint16_t b;
+}CcdPair_t;
+
+// Continuous collisions over one step. The candidate pairs are the particles whose paths over the step may meet, and
+// every one of them, like every particle against the walls, gets the time it first touches. The earliest contact is
+// resolved right at its time, only the particles it involves are moved up to that time, and their other contacts are
+// timed again from their new velocities. Contacts a particle only reaches after being deflected away from the path its
+// pairs were found for go unseen until the next step. All storage is one block of CCD_WORDS() words supplied by the
+// caller, at most 65535 particles and pairs together.
+typedef struct Ccd_s
+{
+    int count;
+    int pair_capacity;
+    int pair_count;
+    int max_events;             // contacts resolved per step at most, the rest of the step runs without them
+    CcdPair_t* pairs;
+    float* time;                // per particle, how far into the step its position is
+    float* impact;              // per entry, when it next touches: walls of each particle, then the pairs
+    uint16_t* heap;             // entries ordered by impact
+    uint16_t* heap_slot;        // where each entry is in the heap
+    uint16_t* adjacency_start;  // per particle, where its pairs start in adjacency
+    uint16_t* adjacency;
+
+    uint32_t events;            // contacts resolved by the last step
+}Ccd_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+void ccd_init(Ccd_t* ccd, int count, int pair_capacity, int max_events, uint32_t* storage);
+void ccd_begin(Ccd_t* ccd);
+// Returns false when the pair does not fit, it is then up to the caller to resolve it
+bool ccd_add_pair(Ccd_t* ccd, int a, int b);
+// Moves the particles dt seconds along their velocities, bouncing them off each other and off the walls in the order
+// the contacts happen. The velocities are taken as they are, friction is up to the caller. Returns the number of
+// particle contacts.
+int ccd_solve(Ccd_t* ccd, ParticleStore_t* store, float dt, float min_distance, float min_x, float max_x, float min_y,
+              float max_y);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CCD_H */
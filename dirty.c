@@ -0,0 +1,111 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "dirty.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define AREA(rect)                      ((int32_t)((rect).right - (rect).left) * ((rect).bottom - (rect).top))
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static DirtyRect_t merged(const DirtyRect_t* a, const DirtyRect_t* b)
+{
+    DirtyRect_t rect;
+
+    rect.left = a->left < b->left ? a->left : b->left;
+    rect.top = a->top < b->top ? a->top : b->top;
+    rect.right = a->right > b->right ? a->right : b->right;
+    rect.bottom = a->bottom > b->bottom ? a->bottom : b->bottom;
+    return rect;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Takes the rect out of the list, the last one fills the hole
+static DirtyRect_t take(DirtyRegion_t* region, int index)
+{
+    DirtyRect_t rect = region->rects[index];
+
+    region->rects[index] = region->rects[--region->count];
+    return rect;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static int cheapest_merge(const DirtyRegion_t* region, const DirtyRect_t* rect)
+{
+    int best = 0;
+    int32_t best_cost = INT32_MAX;
+
+    for(int i = 0; i < region->count; i++)
+    {
+        DirtyRect_t both = merged(&region->rects[i], rect);
+        int32_t cost = AREA(both) - AREA(region->rects[i]) - AREA(*rect);
+
+        if(cost < best_cost)
+        {
+            best = i;
+            best_cost = cost;
+        }
+    }
+    return best;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void dirty_reset(DirtyRegion_t* region, int width, int height)
+{
+    region->width = (int16_t)width;
+    region->height = (int16_t)height;
+    region->count = 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void dirty_add(DirtyRegion_t* region, int left, int top, int right, int bottom)
+{
+    DirtyRect_t rect;
+    int i = 0;
+
+    rect.left = (int16_t)(left < 0 ? 0 : left);
+    rect.top = (int16_t)(top < 0 ? 0 : top);
+    rect.right = (int16_t)(right > region->width ? region->width : right);
+    rect.bottom = (int16_t)(bottom > region->height ? region->height : bottom);
+    if(rect.left >= rect.right || rect.top >= rect.bottom)
+        return;
+
+    // A merge can reach rects that were already checked, so every merge starts the scan over
+    while(i < region->count)
+    {
+        DirtyRect_t* other = &region->rects[i];
+
+        if(dirty_overlaps(other, rect.left, rect.top, rect.right, rect.bottom))
+        {
+            DirtyRect_t old = take(region, i);
+            rect = merged(&old, &rect);
+            i = 0;
+        }
+        else if(i == region->count - 1 && region->count == DIRTY_MAX_RECTS)
+        {
+            DirtyRect_t old = take(region, cheapest_merge(region, &rect));
+            rect = merged(&old, &rect);
+            i = 0;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    region->rects[region->count++] = rect;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool dirty_overlaps(const DirtyRect_t* rect, int left, int top, int right, int bottom)
+{
+    return rect->left < right && left < rect->right && rect->top < bottom && top < rect->bottom;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,58 @@
+#ifndef __DIRTY_H
+#define __DIRTY_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define DIRTY_MAX_RECTS                 32
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Right and bottom are exclusive
+typedef struct DirtyRect_s
+{
+    int16_t left;
+    int16_t top;
+    int16_t right;
+    int16_t bottom;
+}DirtyRect_t;
+
+// The part of the screen that has to be cleared and redrawn, as a bounded list of rects that never overlap, so every
+// pixel is touched once no matter how many rects were added over it.
+typedef struct DirtyRegion_s
+{
+    int16_t width;
+    int16_t height;
+    int count;
+    DirtyRect_t rects[DIRTY_MAX_RECTS];
+}DirtyRegion_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Empties the region, rects added later are clipped to width x height
+void dirty_reset(DirtyRegion_t* region, int width, int height);
+// Rects that overlap the new one are merged into it. When the list is full it is merged with the rect whose union adds
+// the fewest pixels, so the region may cover more than what was added but never less.
+void dirty_add(DirtyRegion_t* region, int left, int top, int right, int bottom);
+bool dirty_overlaps(const DirtyRect_t* rect, int left, int top, int right, int bottom);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DIRTY_H */
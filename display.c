@@ -0,0 +1,148 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "global_includes.h"
+#include <stdbool.h>
+#include "display.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// The app draws on the background layer, whose first buffer is the one LCD_LayerInit() sets up. The second one follows
+// it in SDRAM, one BUFFER_OFFSET further. The foreground layer is left to the overlay, with its buffers after those.
+#define DISPLAY_LAYER                   LTDC_Layer1
+#define DISPLAY_BUFFER(index)           (LCD_FRAME_BUFFER + (index) * BUFFER_OFFSET)
+#define OVERLAY_LAYER                   LTDC_Layer2
+#define OVERLAY_BUFFER(index)           (LCD_FRAME_BUFFER + (DISPLAY_BUFFERS + (index)) * BUFFER_OFFSET)
+
+// Start of the active area, after the synchronization and back porch, as LCD_LayerInit() sets it
+#define ACTIVE_HORIZONTAL_START         30
+#define ACTIVE_VERTICAL_START           4
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static int back;
+static SemaphoreHandle_t back_free;
+static StaticSemaphore_t back_free_buffer;
+
+static uint16_t overlay_height;
+static int overlay_back;
+static bool overlay_drawn;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void display_overlay_init(uint16_t height)
+{
+    LTDC_Layer_InitTypeDef layer;
+    
+    // Only the rows it covers are fetched, the layer window ends there
+    layer.LTDC_HorizontalStart = ACTIVE_HORIZONTAL_START;
+    layer.LTDC_HorizontalStop = ACTIVE_HORIZONTAL_START + LCD_PIXEL_WIDTH - 1;
+    layer.LTDC_VerticalStart = ACTIVE_VERTICAL_START;
+    layer.LTDC_VerticalStop = ACTIVE_VERTICAL_START + height - 1;
+    layer.LTDC_PixelFormat = LTDC_Pixelformat_ARGB4444;
+    layer.LTDC_ConstantAlpha = 255;
+    layer.LTDC_DefaultColorBlue = 0;
+    layer.LTDC_DefaultColorGreen = 0;
+    layer.LTDC_DefaultColorRed = 0;
+    layer.LTDC_DefaultColorAlpha = 0;
+    // Each pixel's own alpha decides how much of the frame shows through
+    layer.LTDC_BlendingFactor_1 = LTDC_BlendingFactor1_PAxCA;
+    layer.LTDC_BlendingFactor_2 = LTDC_BlendingFactor2_PAxCA;
+    layer.LTDC_CFBLineLength = LCD_PIXEL_WIDTH * 2 + 3;
+    layer.LTDC_CFBPitch = LCD_PIXEL_WIDTH * 2;
+    layer.LTDC_CFBLineNumber = height;
+    layer.LTDC_CFBStartAdress = OVERLAY_BUFFER(0);
+    LTDC_LayerInit(OVERLAY_LAYER, &layer);
+    
+    // Fully transparent until something is drawn on it
+    for(int i = 0; i < DISPLAY_BUFFERS; i++)
+    {
+        LCD_SetFrameBuffer(OVERLAY_BUFFER(i));
+        LCD_Clear(0x0000);
+    }
+    
+    overlay_height = height;
+    overlay_back = 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void display_init(uint16_t color)
+{
+    for(int i = 0; i < DISPLAY_BUFFERS; i++)
+    {
+        LCD_SetFrameBuffer(DISPLAY_BUFFER(i));
+        LCD_Clear(color);
+    }
+    
+    LTDC_LayerAddress(DISPLAY_LAYER, DISPLAY_BUFFER(0));
+    // Without an overlay the foreground layer would cover the frame with whatever its buffer holds
+    LTDC_LayerCmd(OVERLAY_LAYER, overlay_height ? ENABLE : DISABLE);
+    LTDC_ReloadConfig(LTDC_IMReload);
+    back = 1;
+    
+    // The back buffer starts off screen
+    back_free = xSemaphoreCreateBinaryStatic(&back_free_buffer);
+    xSemaphoreGive(back_free);
+    
+    LTDC_ClearITPendingBit(LTDC_IT_RR);
+    LTDC_ITConfig(LTDC_IT_RR, ENABLE);
+    NVIC_SetPriority(LTDC_IRQn, GRAPHICS_IRQ_PRIORITY);
+    NVIC_EnableIRQ(LTDC_IRQn);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+int display_begin_frame(void)
+{
+    xSemaphoreTake(back_free, portMAX_DELAY);
+    LCD_SetFrameBuffer(DISPLAY_BUFFER(back));
+    
+    return back;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void display_begin_overlay(void)
+{
+    LCD_SetFrameBuffer(OVERLAY_BUFFER(overlay_back));
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void display_end_overlay(void)
+{
+    LCD_SetFrameBuffer(DISPLAY_BUFFER(back));
+    overlay_drawn = true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void display_present(void)
+{
+    // The new addresses sit in the shadow registers until the next vertical blanking, the reload interrupt then tells
+    // that the old front buffers are no longer scanned out
+    LTDC_LayerAddress(DISPLAY_LAYER, DISPLAY_BUFFER(back));
+    if(overlay_drawn)
+    {
+        LTDC_LayerAddress(OVERLAY_LAYER, OVERLAY_BUFFER(overlay_back));
+        overlay_back ^= 1;
+        overlay_drawn = false;
+    }
+    LTDC_ReloadConfig(LTDC_VBReload);
+    back ^= 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void display_reload_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    
+    if(LTDC_GetITStatus(LTDC_IT_RR) == RESET)
+        return;
+    
+    LTDC_ClearITPendingBit(LTDC_IT_RR);
+    xSemaphoreGiveFromISR(back_free, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+// ---------------------------------------------------------------------------------------------------------------------
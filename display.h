@@ -0,0 +1,46 @@
+#ifndef __DISPLAY_H
+#define __DISPLAY_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define DISPLAY_BUFFERS                 2
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Double buffered background layer (LTDC layer 1): one buffer is scanned out while the other one is drawn, and they are
+// swapped during vertical blanking so a frame is never shown half drawn.
+// display_begin_frame() blocks until the back buffer is off screen, points the LCD driver at it and returns its index.
+// display_present() queues it to be shown from the next vertical blanking on.
+void display_init(uint16_t color);
+int display_begin_frame(void);
+void display_present(void);
+
+// Optional foreground layer (LTDC layer 2) over the top height rows of the frame, set up before display_init(). Its
+// pixels are ARGB4444, so whatever is not drawn on stays see through and the frame below never has to be drawn again
+// for it. It is double buffered like the frame but only swapped when it changed: between display_begin_frame() and
+// display_present(), display_begin_overlay() points the LCD driver at its back buffer and display_end_overlay() back
+// at the frame's. A new overlay must be drawn in full.
+void display_overlay_init(uint16_t height);
+void display_begin_overlay(void);
+void display_end_overlay(void);
+
+// Target only, called from LTDC_IRQHandler
+void display_reload_isr(void);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DISPLAY_H */
@@ -0,0 +1,68 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "fixed_step.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static void advance(FixedStep_t* clock)
+{
+    clock->remainder += clock->clock_rate;
+    clock->deadline += clock->remainder / clock->rate;
+    clock->remainder %= clock->rate;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void fixed_step_init(FixedStep_t* clock, uint32_t rate, uint32_t clock_rate, uint32_t max_steps, uint32_t now)
+{
+    clock->rate = rate;
+    clock->clock_rate = clock_rate;
+    clock->max_steps = max_steps;
+    clock->deadline = now;
+    clock->remainder = 0;
+
+    clock->steps = 0;
+    clock->overruns = 0;
+    clock->dropped = 0;
+    clock->late = 0;
+    clock->max_late = 0;
+
+    // The first step is one period away
+    advance(clock);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t fixed_step_due(FixedStep_t* clock, uint32_t now)
+{
+    uint32_t due = 0;
+
+    // Differences keep working across the wrap of the clock
+    if((int32_t)(now - clock->deadline) < 0)
+        return 0;
+
+    clock->late = now - clock->deadline;
+    if(clock->late > clock->max_late)
+        clock->max_late = clock->late;
+
+    while((int32_t)(now - clock->deadline) >= 0)
+    {
+        due++;
+        advance(clock);
+    }
+
+    if(due > 1)
+        clock->overruns++;
+    if(due > clock->max_steps)
+    {
+        clock->dropped += due - clock->max_steps;
+        due = clock->max_steps;
+    }
+
+    clock->steps += due;
+    return due;
+}
+// ---------------------------------------------------------------------------------------------------------------------
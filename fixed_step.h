@@ -0,0 +1,49 @@
+#ifndef __FIXED_STEP_H
+#define __FIXED_STEP_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Fixed timestep schedule over a free running clock. Step k is due at clock tick k * clock_rate / rate, so the
+// cadence is exact on average even when a step period is not a whole number of ticks, and does not drift with how long
+// the steps take. A caller that wakes up late gets the missed steps to catch up on, up to max_steps, the rest are
+// dropped and the schedule starts over from there.
+typedef struct FixedStep_s
+{
+    uint32_t rate;              // steps per second
+    uint32_t clock_rate;        // clock ticks per second
+    uint32_t max_steps;         // most steps one wake may run
+    uint32_t deadline;          // clock tick the next step is due at
+    uint32_t remainder;         // fraction of a tick the deadlines are behind, in 1 / rate ticks
+
+    uint32_t steps;             // steps handed out
+    uint32_t overruns;          // wakes that found more than one step due, the previous ones took too long
+    uint32_t dropped;           // steps given up because the backlog was longer than max_steps
+    uint32_t late;              // ticks the last wake came after its deadline
+    uint32_t max_late;
+}FixedStep_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+void fixed_step_init(FixedStep_t* clock, uint32_t rate, uint32_t clock_rate, uint32_t max_steps, uint32_t now);
+// Steps due at now, the deadline moves past now
+uint32_t fixed_step_due(FixedStep_t* clock, uint32_t now);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIXED_STEP_H */
@@ -0,0 +1,135 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "grid.h"
+#include <string.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define STRIDED(ptr, index, stride)     (*(const float*)((const char*)(ptr) + (size_t)(index) * (stride)))
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static int cell_of(const Grid_t* grid, float x, float y)
+{
+    int cx = (int)(x * grid->inv_cell_size);
+    int cy = (int)(y * grid->inv_cell_size);
+
+    // Positions are clamped to the screen, but the right/bottom edge itself maps one cell past the end
+    if(cx < 0)
+        cx = 0;
+    else if(cx >= grid->cols)
+        cx = grid->cols - 1;
+
+    if(cy < 0)
+        cy = 0;
+    else if(cy >= grid->rows)
+        cy = grid->rows - 1;
+
+    return cy * grid->cols + cx;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool cell_pairs(const Grid_t* grid, int cell, int other, bool (*iter)(int a, int b, void* udata), void* udata)
+{
+    for(int i = grid->cell_start[cell]; i < grid->cell_start[cell + 1]; i++)
+    {
+        for(int j = grid->cell_start[other]; j < grid->cell_start[other + 1]; j++)
+        {
+            if(!iter(grid->items[i], grid->items[j], udata))
+                return false;
+        }
+    }
+
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void grid_init(Grid_t* grid, int width, int height, int cell_size, uint16_t* cell_start, uint16_t* items)
+{
+    grid->inv_cell_size = 1.0f / cell_size;
+    grid->cols = GRID_COLS(width, cell_size);
+    grid->rows = GRID_ROWS(height, cell_size);
+    grid->count = 0;
+    grid->cell_start = cell_start;
+    grid->items = items;
+
+    memset(grid->cell_start, 0, (grid->cols * grid->rows + 1) * sizeof(uint16_t));
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void grid_build(Grid_t* grid, const float* x, const float* y, size_t stride, int count)
+{
+    int cells = grid->cols * grid->rows;
+
+    memset(grid->cell_start, 0, (cells + 1) * sizeof(uint16_t));
+
+    // Histogram, then turn it into running end offsets
+    for(int i = 0; i < count; i++)
+    {
+        grid->cell_start[cell_of(grid, STRIDED(x, i, stride), STRIDED(y, i, stride))]++;
+    }
+
+    for(int c = 1; c <= cells; c++)
+    {
+        grid->cell_start[c] += grid->cell_start[c - 1];
+    }
+
+    // Scattering backwards walks every end offset down to its start offset, so no separate cursor array is needed
+    for(int i = count - 1; i >= 0; i--)
+    {
+        int cell = cell_of(grid, STRIDED(x, i, stride), STRIDED(y, i, stride));
+        grid->items[--grid->cell_start[cell]] = (uint16_t)i;
+    }
+
+    grid->cell_start[cells] = (uint16_t)count;
+    grid->count = count;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool grid_pairs(const Grid_t* grid, bool (*iter)(int a, int b, void* udata), void* udata)
+{
+    for(int cy = 0; cy < grid->rows; cy++)
+    {
+        for(int cx = 0; cx < grid->cols; cx++)
+        {
+            int cell = cy * grid->cols + cx;
+
+            if(grid->cell_start[cell] == grid->cell_start[cell + 1])
+                continue;
+
+            // Pairs inside the cell itself
+            for(int i = grid->cell_start[cell]; i < grid->cell_start[cell + 1]; i++)
+            {
+                for(int j = i + 1; j < grid->cell_start[cell + 1]; j++)
+                {
+                    if(!iter(grid->items[i], grid->items[j], udata))
+                        return false;
+                }
+            }
+
+            // Only the forward half of the neighbourhood, so every pair is reported exactly once
+            if(cx + 1 < grid->cols && !cell_pairs(grid, cell, cell + 1, iter, udata))
+                return false;
+
+            if(cy + 1 < grid->rows)
+            {
+                if(cx > 0 && !cell_pairs(grid, cell, cell + grid->cols - 1, iter, udata))
+                    return false;
+                if(!cell_pairs(grid, cell, cell + grid->cols, iter, udata))
+                    return false;
+                if(cx + 1 < grid->cols && !cell_pairs(grid, cell, cell + grid->cols + 1, iter, udata))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
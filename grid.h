@@ -0,0 +1,51 @@
+#ifndef __GRID_H
+#define __GRID_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define GRID_COLS(width, cell_size)                 (((width) + (cell_size) - 1) / (cell_size))
+#define GRID_ROWS(height, cell_size)                (((height) + (cell_size) - 1) / (cell_size))
+#define GRID_CELLS(width, height, cell_size)        (GRID_COLS(width, cell_size) * GRID_ROWS(height, cell_size))
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Uniform grid rebuilt from scratch every frame with a counting sort. All storage is supplied by the caller:
+// cell_start needs GRID_CELLS() + 1 entries and items needs one entry per indexed element.
+typedef struct Grid_s
+{
+    float inv_cell_size;
+    int cols;
+    int rows;
+    int count;
+    uint16_t* cell_start;
+    uint16_t* items;
+}Grid_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+void grid_init(Grid_t* grid, int width, int height, int cell_size, uint16_t* cell_start, uint16_t* items);
+void grid_build(Grid_t* grid, const float* x, const float* y, size_t stride, int count);
+bool grid_pairs(const Grid_t* grid, bool (*iter)(int a, int b, void* udata), void* udata);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GRID_H */
@@ -0,0 +1,72 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "app.h"
+#include "alloc_guard.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Every bench binary is app.c or app.cpp compiled for one configuration, see bench_variant() in CMakeLists.txt
+#ifndef BENCH_ENGINE
+#define BENCH_ENGINE                    "?"
+#endif
+
+// Friction slows the simulation down over time, so every engine measures the same frames of it: the pairs and
+// collisions per frame only compare across engines, and the times only across runs, when the frame count is the same
+#define WARMUP_FRAMES                   10
+#define DEFAULT_FRAMES                  300
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+// usage: bench_<engine>_<particles>_<radius> [frames]
+int main(int argc, char** argv)
+{
+    int frames = (argc > 1) ? atoi(argv[1]) : DEFAULT_FRAMES;
+
+    alloc_guard_init();
+    app_init();
+
+    for(int i = 0; i < WARMUP_FRAMES; i++)
+    {
+        app_simulate();
+    }
+
+    unsigned long allocs = alloc_guard_total();
+    unsigned long collisions = 0;
+    unsigned long pairs = 0;
+    double begin = now_secs();
+
+    for(int i = 0; i < frames; i++)
+    {
+        app_simulate();
+        collisions += app_get_stats()->collisions;
+        pairs += app_get_stats()->pairs;
+    }
+    double elapsed = now_secs() - begin;
+    allocs = alloc_guard_total() - allocs;
+
+    printf("%-8s particles=%-5d radius=%-2d %10.0f ns/frame %8.1f pairs/frame %8.1f collisions/frame "
+           "%8.2f allocs/frame\n", BENCH_ENGINE, NUMBER_OF_PARTICLES, CIRCLE_RADIUS,
+           elapsed / frames * 1e9, (double)pairs / frames, (double)collisions / frames, (double)allocs / frames);
+
+    return 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
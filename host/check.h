@@ -0,0 +1,17 @@
+#ifndef __CHECK_H
+#define __CHECK_H
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Host tests are bool functions that stop at the first thing that does not hold, with a printf style message saying
+// what it was
+#define CHECK(cond, ...)                do { if(!(cond)) { fprintf(stderr, __VA_ARGS__); return false; } } while(0)
+// ---------------------------------------------------------------------------------------------------------------------
+
+#endif /* __CHECK_H */
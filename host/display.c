@@ -0,0 +1,87 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdbool.h>
+#include "display.h"
+#include "stm32f429i_discovery_lcd.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static uint16_t buffers[DISPLAY_BUFFERS][LCD_PIXEL_WIDTH * LCD_PIXEL_HEIGHT];
+static int back;
+
+// Full screen like the frame's, only the top overlay_height rows are ever drawn on
+static uint16_t overlay_buffers[DISPLAY_BUFFERS][LCD_PIXEL_WIDTH * LCD_PIXEL_HEIGHT];
+static uint16_t overlay_height;
+static int overlay_back;
+static bool overlay_drawn;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+// The host has no scan out to wait for, the swap only changes which buffers LCD_GetFrameBuffer() and
+// LCD_GetOverlayBuffer() return
+void display_overlay_init(uint16_t height)
+{
+    for(int i = 0; i < DISPLAY_BUFFERS; i++)
+    {
+        LCD_SetFrameBuffer(overlay_buffers[i]);
+        LCD_Clear(0x0000);
+    }
+    
+    overlay_height = height;
+    overlay_back = 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void display_init(uint16_t color)
+{
+    for(int i = 0; i < DISPLAY_BUFFERS; i++)
+    {
+        LCD_SetFrameBuffer(buffers[i]);
+        LCD_Clear(color);
+    }
+    
+    LCD_ShowFrameBuffer(buffers[0]);
+    LCD_ShowOverlayBuffer(overlay_height ? overlay_buffers[0] : NULL);
+    back = 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+int display_begin_frame(void)
+{
+    LCD_SetFrameBuffer(buffers[back]);
+    
+    return back;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void display_begin_overlay(void)
+{
+    LCD_SetFrameBuffer(overlay_buffers[overlay_back]);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void display_end_overlay(void)
+{
+    LCD_SetFrameBuffer(buffers[back]);
+    overlay_drawn = true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void display_present(void)
+{
+    LCD_ShowFrameBuffer(buffers[back]);
+    back ^= 1;
+    
+    if(overlay_drawn)
+    {
+        LCD_ShowOverlayBuffer(overlay_buffers[overlay_back]);
+        overlay_back ^= 1;
+        overlay_drawn = false;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,80 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "lcd_dma2d.h"
+#include "sprites.h"
+#include "stm32f429i_discovery_lcd.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+// The host has no DMA2D, every operation is done by the time it returns and every fence is already reached
+void lcd_dma2d_init(void)
+{
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_clear(uint16_t color)
+{
+    LCD_Clear(color);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_fill(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t color)
+{
+    uint16_t text_color, back_color;
+    
+    LCD_GetColors(&text_color, &back_color);
+    LCD_SetTextColor(color);
+    LCD_DrawFullRect(x, y, width, height);
+    LCD_SetTextColor(text_color);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_copy(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t* source,
+                    uint16_t source_width)
+{
+    uint16_t* buffer = LCD_GetDrawBuffer();
+    
+    for(uint16_t row = 0; row < height; row++)
+    {
+        for(uint16_t column = 0; column < width; column++)
+        {
+            buffer[x + column + LCD_PIXEL_WIDTH * (y + row)] = source[column + source_width * row];
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_blend(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* alpha,
+                     uint16_t source_width, uint16_t color)
+{
+    uint16_t* buffer = LCD_GetDrawBuffer();
+    
+    for(uint16_t row = 0; row < height; row++)
+    {
+        for(uint16_t column = 0; column < width; column++)
+        {
+            uint16_t* pixel = &buffer[x + column + LCD_PIXEL_WIDTH * (y + row)];
+            *pixel = sprite_blend_pixel(color, *pixel, alpha[column + source_width * row]);
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t lcd_dma2d_fence(void)
+{
+    return 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_wait_fence(uint32_t fence)
+{
+    (void)fence;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_wait(void)
+{
+}
+// ---------------------------------------------------------------------------------------------------------------------
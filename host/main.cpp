@@ -0,0 +1,127 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "app.h"
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define DEFAULT_FRAMES                  1000
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The overlay is ARGB4444 and blended over the frame by its own alpha, like the LTDC does
+static bool write_ppm(const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if(!f)
+        return false;
+
+    const uint16_t* fb = LCD_GetFrameBuffer();
+    const uint16_t* overlay = LCD_GetOverlayBuffer();
+    fprintf(f, "P6\n%d %d\n255\n", LCD_PIXEL_WIDTH, LCD_PIXEL_HEIGHT);
+    for(int i = 0; i < LCD_PIXEL_WIDTH * LCD_PIXEL_HEIGHT; i++)
+    {
+        uint8_t rgb[3] = {
+            (uint8_t)(((fb[i] >> 11) & 0x1F) << 3),
+            (uint8_t)(((fb[i] >> 5) & 0x3F) << 2),
+            (uint8_t)((fb[i] & 0x1F) << 3)
+        };
+        if(overlay)
+        {
+            int alpha = ((overlay[i] >> 12) & 0xF) * 17;
+            for(int c = 0; c < 3; c++)
+            {
+                int top = ((overlay[i] >> (8 - 4 * c)) & 0xF) * 17;
+                rgb[c] = (uint8_t)((top * alpha + rgb[c] * (255 - alpha)) / 255);
+            }
+        }
+        fwrite(rgb, 1, sizeof(rgb), f);
+    }
+
+    fclose(f);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Microseconds per frame over the last frames of each phase
+static void print_profile(void)
+{
+    double us = 1e6 / cycle_counter_rate();
+    
+    printf("%-10s %10s %10s %10s %10s\n", "phase", "min us", "avg us", "p99 us", "max us");
+    for(int phase = 0; phase < PROFILE_PHASES; phase++)
+    {
+        ProfileStats_t stats;
+        profiler_stats((ProfilePhase_t)phase, &stats);
+        printf("%-10s %10.1f %10.1f %10.1f %10.1f\n", profiler_phase_name((ProfilePhase_t)phase), stats.min * us,
+               stats.avg * us, stats.p99 * us, stats.max * us);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+// usage: particles_host [frames] [frame.ppm]
+// The simulation and the rendering run on threads of their own like the firmware's tasks, frames counts the steps
+int main(int argc, char** argv)
+{
+    int frames = (argc > 1) ? atoi(argv[1]) : DEFAULT_FRAMES;
+    std::atomic<bool> simulating(true);
+    long rendered = 0;
+
+    LCD_SetLayer(LCD_BACKGROUND_LAYER);
+    LCD_Clear(LCD_COLOR_WHITE);
+    app_init();
+
+    double begin = now_secs();
+    std::thread render([&]()
+    {
+        while(simulating.load())
+        {
+            app_render();
+            rendered++;
+        }
+    });
+    for(int i = 0; i < frames; i++)
+    {
+        app_simulate();
+    }
+    simulating.store(false);
+    render.join();
+    double elapsed = now_secs() - begin;
+
+    // The last step may not have been drawn yet
+    app_render();
+
+    printf("%d frames in %.3f secs, %.0f ns/frame, %.0f frames/sec, %ld rendered\n",
+           frames, elapsed, elapsed / frames * 1e9, frames / elapsed, rendered);
+    print_profile();
+
+    if(argc > 2 && !write_ppm(argv[2]))
+    {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,6 @@
+// rtree.c carries its own test suite behind RTREE_TEST. It is written in C, while the rest of the host build compiles
+// rtree.c as C++ like the EWARM project does, so it is built from this separate translation unit.
+// The suite checks everything with assert(), which the release flags of the host build would compile out
+#undef NDEBUG
+#define RTREE_TEST
+#include "rtree.c"
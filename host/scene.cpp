@@ -0,0 +1,102 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "scene.h"
+
+#include <stdlib.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported variables
+// ---------------------------------------------------------------------------------------------------------------------
+float scene_x[SCENE_COUNT];
+float scene_y[SCENE_COUNT];
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+float scene_random(float max)
+{
+    return (float)rand() / RAND_MAX * max;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void scene_init(void)
+{
+    srand(1);
+    for(int i = 0; i < SCENE_COUNT; i++)
+    {
+        scene_x[i] = (float)(int)scene_random(SCENE_WIDTH);
+        scene_y[i] = (float)(int)scene_random(SCENE_HEIGHT);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void scene_step(int frame)
+{
+    for(int i = 0; i < SCENE_COUNT; i++)
+    {
+        if(rand() % 100 == 0)
+        {
+            scene_x[i] = scene_random(SCENE_WIDTH);
+            scene_y[i] = scene_random(SCENE_HEIGHT);
+        }
+        else if(frame % 2)
+        {
+            scene_x[i] += scene_random(6.0f) - 3.0f;
+            scene_y[i] += scene_random(6.0f) - 3.0f;
+        }
+        else
+        {
+            scene_x[i] += (float)(rand() % 3 - 1);
+            scene_y[i] += (float)(rand() % 3 - 1);
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void scene_rect(int item, float* rect)
+{
+    rect[0] = scene_x[item] - SCENE_EXTENT;
+    rect[1] = scene_y[item] - SCENE_EXTENT;
+    rect[2] = scene_x[item] + SCENE_EXTENT;
+    rect[3] = scene_y[item] + SCENE_EXTENT;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool scene_rects_overlap(const float* a, const float* b)
+{
+    return a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3];
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool scene_add_pair(PairSet_t* pairs, int a, int b)
+{
+    if(a > b)
+    {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    return pairs->insert(std::make_pair(a, b)).second;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+PairSet_t scene_brute_force_pairs(void)
+{
+    PairSet_t expected;
+    float a_rect[4], b_rect[4];
+
+    for(int a = 0; a < SCENE_COUNT; a++)
+    {
+        scene_rect(a, a_rect);
+        for(int b = a + 1; b < SCENE_COUNT; b++)
+        {
+            scene_rect(b, b_rect);
+            if(scene_rects_overlap(a_rect, b_rect))
+                expected.insert(std::make_pair(a, b));
+        }
+    }
+    return expected;
+}
+// ---------------------------------------------------------------------------------------------------------------------
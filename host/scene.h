@@ -0,0 +1,50 @@
+#ifndef __SCENE_H
+#define __SCENE_H
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <set>
+#include <utility>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Items moving about the screen like the particles do, for the broad phase tests to check against brute force. Every
+// item is a square of SCENE_EXTENT on each side of its centre.
+#define SCENE_COUNT                     300
+#define SCENE_EXTENT                    4.0f
+#define SCENE_WIDTH                     240
+#define SCENE_HEIGHT                    320
+#define SCENE_FRAMES                    300
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Pairs of items, the lower index first
+typedef std::set<std::pair<int, int> > PairSet_t;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported variables
+// ---------------------------------------------------------------------------------------------------------------------
+extern float scene_x[SCENE_COUNT];
+extern float scene_y[SCENE_COUNT];
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+float scene_random(float max);
+// Seeds rand() the same way every time and puts the items on whole pixels, so that rects touch exactly now and then
+void scene_init(void);
+// Moves every item for the next frame: one in a hundred jumps across the screen, the others take small steps, of whole
+// pixels on even frames and of a few fractional pixels on odd ones
+void scene_step(int frame);
+// Min x, min y, max x, max y like the rtree's
+void scene_rect(int item, float* rect);
+bool scene_rects_overlap(const float* a, const float* b);
+// Returns false when the pair was already there, which is a pair reported twice
+bool scene_add_pair(PairSet_t* pairs, int a, int b);
+PairSet_t scene_brute_force_pairs(void);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#endif /* __SCENE_H */
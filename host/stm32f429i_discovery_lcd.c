@@ -0,0 +1,132 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "stm32f429i_discovery_lcd.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static uint16_t frame_buffer[LCD_PIXEL_WIDTH * LCD_PIXEL_HEIGHT];
+static uint16_t* draw_buffer = frame_buffer;
+static uint16_t* shown_buffer = frame_buffer;
+static uint16_t* shown_overlay;
+static uint16_t current_text_color = LCD_COLOR_BLACK;
+static uint16_t current_back_color = LCD_COLOR_WHITE;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static void put_pixel(int x, int y, uint16_t color)
+{
+    // The target writes out of bounds coordinates into whatever SDRAM follows, the host clips them instead
+    if(x < 0 || x >= LCD_PIXEL_WIDTH || y < 0 || y >= LCD_PIXEL_HEIGHT)
+        return;
+
+    draw_buffer[x + LCD_PIXEL_WIDTH * y] = color;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void LCD_SetLayer(uint32_t Layerx)
+{
+    (void)Layerx;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void LCD_GetColors(uint16_t* TextColor, uint16_t* BackColor)
+{
+    *TextColor = current_text_color;
+    *BackColor = current_back_color;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void LCD_SetTextColor(uint16_t Color)
+{
+    current_text_color = Color;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void LCD_Clear(uint16_t Color)
+{
+    for(int i = 0; i < LCD_PIXEL_WIDTH * LCD_PIXEL_HEIGHT; i++)
+    {
+        draw_buffer[i] = Color;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void LCD_DrawCircle(uint16_t Xpos, uint16_t Ypos, uint16_t Radius)
+{
+    // Same rasterization as the target driver
+    int x = -Radius, y = 0, err = 2 - 2 * Radius, e2;
+    do
+    {
+        put_pixel(Xpos - x, Ypos + y, current_text_color);
+        put_pixel(Xpos + x, Ypos + y, current_text_color);
+        put_pixel(Xpos + x, Ypos - y, current_text_color);
+        put_pixel(Xpos - x, Ypos - y, current_text_color);
+
+        e2 = err;
+        if(e2 <= y)
+        {
+            err += ++y * 2 + 1;
+            if(-x == y && e2 <= x)
+                e2 = 0;
+        }
+        if(e2 > x)
+            err += ++x * 2 + 1;
+    }
+    while(x <= 0);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void LCD_DrawFullRect(uint16_t Xpos, uint16_t Ypos, uint16_t Width, uint16_t Height)
+{
+    for(int y = Ypos; y < Ypos + Height; y++)
+    {
+        for(int x = Xpos; x < Xpos + Width; x++)
+        {
+            put_pixel(x, y, current_text_color);
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void LCD_SetFrameBuffer(uint16_t* Buffer)
+{
+    draw_buffer = Buffer;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void LCD_ShowFrameBuffer(uint16_t* Buffer)
+{
+    shown_buffer = Buffer;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint16_t* LCD_GetFrameBuffer(void)
+{
+    return shown_buffer;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint16_t* LCD_GetDrawBuffer(void)
+{
+    return draw_buffer;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void LCD_ShowOverlayBuffer(uint16_t* Buffer)
+{
+    shown_overlay = Buffer;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint16_t* LCD_GetOverlayBuffer(void)
+{
+    return shown_overlay;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,67 @@
+#ifndef __STM32F429I_DISCOVERY_LCD_H
+#define __STM32F429I_DISCOVERY_LCD_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Host replacement of Utilities/STM32F429I-Discovery/stm32f429i_discovery_lcd.h. It keeps the names and constants
+// used by the application, but draws into a plain RGB565 buffer in memory instead of the SDRAM behind the LTDC.
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "../Utilities/Common/fonts.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define LCD_PIXEL_WIDTH          ((uint16_t)240)
+#define LCD_PIXEL_HEIGHT         ((uint16_t)320)
+
+#define LCD_COLOR_WHITE          0xFFFF
+#define LCD_COLOR_BLACK          0x0000
+#define LCD_COLOR_GREY           0xF7DE
+#define LCD_COLOR_BLUE           0x001F
+#define LCD_COLOR_BLUE2          0x051F
+#define LCD_COLOR_RED            0xF800
+#define LCD_COLOR_MAGENTA        0xF81F
+#define LCD_COLOR_GREEN          0x07E0
+#define LCD_COLOR_CYAN           0x7FFF
+#define LCD_COLOR_YELLOW         0xFFE0
+
+#define LCD_BACKGROUND_LAYER     0x0000
+#define LCD_FOREGROUND_LAYER     0x0001
+
+#define ASSEMBLE_RGB(R, G, B)    ((((R)& 0xF8) << 8) | (((G) & 0xFC) << 3) | (((B) & 0xF8) >> 3))
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+void     LCD_SetLayer(uint32_t Layerx);
+void     LCD_GetColors(uint16_t* TextColor, uint16_t* BackColor);
+void     LCD_SetTextColor(uint16_t Color);
+void     LCD_Clear(uint16_t Color);
+void     LCD_DrawCircle(uint16_t Xpos, uint16_t Ypos, uint16_t Radius);
+void     LCD_DrawFullRect(uint16_t Xpos, uint16_t Ypos, uint16_t Width, uint16_t Height);
+
+void     LCD_SetFrameBuffer(uint16_t* Buffer);
+
+// Host only: the buffer on screen, LCD_PIXEL_WIDTH * LCD_PIXEL_HEIGHT pixels, row major. Both it and the one drawn into
+// are an internal buffer until they are set.
+void     LCD_ShowFrameBuffer(uint16_t* Buffer);
+uint16_t* LCD_GetFrameBuffer(void);
+uint16_t* LCD_GetDrawBuffer(void);
+// Host only: the ARGB4444 layer shown over the frame buffer, same size and layout, NULL when there is none
+void     LCD_ShowOverlayBuffer(uint16_t* Buffer);
+uint16_t* LCD_GetOverlayBuffer(void);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F429I_DISCOVERY_LCD_H */
@@ -0,0 +1,229 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "aabb_tree.h"
+#include "check.h"
+#include "scene.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <set>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define MARGIN                          2.0f
+// Deepest a leaf may sit once the rotations have had their say. A balanced tree of the scene is 9 deep, the first
+// scatter of a tree built along a line leaves it at 37 and the later ones at about 16, and without rotations the line
+// alone makes it 275 deep.
+#define MAX_DEPTH                       40
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static int leaves[SCENE_COUNT];
+static AabbNode_t nodes[AABB_TREE_NODES(SCENE_COUNT)];
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static bool collect_pair(const float* rect, int a, const float* other_rect, int b, void* udata)
+{
+    return scene_add_pair((PairSet_t*)udata, a, b);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool collect_item(const float* rect, int item, void* udata)
+{
+    std::set<int>* found = (std::set<int>*)udata;
+
+    return found->insert(item).second;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static int depth(const AabbTree_t* tree, int node)
+{
+    const AabbNode_t* current = &tree->nodes[node];
+
+    if(current->child[0] == AABB_TREE_NULL)
+        return 0;
+
+    int a = depth(tree, current->child[0]);
+    int b = depth(tree, current->child[1]);
+
+    return 1 + (a > b ? a : b);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Every branch box is exactly the union of its children, every fat box holds its rect, and the parent links agree
+static bool check_node(const AabbTree_t* tree, int node, int* leaf_count)
+{
+    const AabbNode_t* current = &tree->nodes[node];
+
+    if(current->child[0] == AABB_TREE_NULL)
+    {
+        CHECK(current->box[0] <= current->rect[0] && current->box[1] <= current->rect[1] &&
+              current->rect[2] <= current->box[2] && current->rect[3] <= current->box[3],
+              "leaf %d outside its fat box\n", node);
+        CHECK(leaves[current->item] == node, "leaf %d holds item %d stored elsewhere\n", node, current->item);
+        (*leaf_count)++;
+        return true;
+    }
+
+    const float* a = tree->nodes[current->child[0]].box;
+    const float* b = tree->nodes[current->child[1]].box;
+
+    for(int k = 0; k < 2; k++)
+    {
+        CHECK(tree->nodes[current->child[k]].parent == node, "child %d of %d has another parent\n", k, node);
+        if(!check_node(tree, current->child[k], leaf_count))
+            return false;
+    }
+    CHECK(current->box[0] == (a[0] < b[0] ? a[0] : b[0]) && current->box[1] == (a[1] < b[1] ? a[1] : b[1]) &&
+          current->box[2] == (a[2] > b[2] ? a[2] : b[2]) && current->box[3] == (a[3] > b[3] ? a[3] : b[3]),
+          "branch %d is not the union of its children\n", node);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool check_tree(const AabbTree_t* tree, int frame)
+{
+    int leaf_count = 0;
+
+    CHECK(tree->nodes[tree->root].parent == AABB_TREE_NULL, "root has a parent in frame %d\n", frame);
+    CHECK(check_node(tree, tree->root, &leaf_count), "broken in frame %d\n", frame);
+    CHECK(leaf_count == SCENE_COUNT, "%d leaves instead of %d in frame %d\n", leaf_count, SCENE_COUNT, frame);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool check_search(const AabbTree_t* tree, int frame)
+{
+    float query[4];
+    float rect[4];
+    std::set<int> found, expected;
+
+    query[0] = scene_random(SCENE_WIDTH);
+    query[1] = scene_random(SCENE_HEIGHT);
+    query[2] = query[0] + scene_random(60.0f);
+    query[3] = query[1] + scene_random(60.0f);
+
+    CHECK(aabb_tree_search(tree, query, collect_item, &found), "search reported twice in frame %d\n", frame);
+    for(int i = 0; i < SCENE_COUNT; i++)
+    {
+        scene_rect(i, rect);
+        if(scene_rects_overlap(rect, query))
+            expected.insert(i);
+    }
+    CHECK(found == expected, "search found %d instead of %d in frame %d\n", (int)found.size(), (int)expected.size(),
+          frame);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The scene's moves, with some items leaving and coming back on top
+static bool run(void)
+{
+    AabbTree_t tree;
+    float rect[4];
+    uint32_t moves = 0;
+
+    scene_init();
+    aabb_tree_init(&tree, MARGIN, nodes, AABB_TREE_NODES(SCENE_COUNT));
+    for(int i = 0; i < SCENE_COUNT; i++)
+    {
+        scene_rect(i, rect);
+        leaves[i] = aabb_tree_insert(&tree, rect, i);
+        CHECK(leaves[i] >= 0, "no room for item %d\n", i);
+    }
+    scene_rect(0, rect);
+    CHECK(aabb_tree_insert(&tree, rect, 0) < 0, "inserted past the node count\n");
+
+    for(int frame = 0; frame < SCENE_FRAMES; frame++)
+    {
+        PairSet_t found;
+
+        if(!check_tree(&tree, frame) || !check_search(&tree, frame))
+            return false;
+        CHECK(aabb_tree_self_join(&tree, collect_pair, &found), "pair reported twice in frame %d\n", frame);
+        CHECK(found == scene_brute_force_pairs(), "%d pairs instead of %d in frame %d\n", (int)found.size(),
+              (int)scene_brute_force_pairs().size(), frame);
+
+        scene_step(frame);
+        for(int i = 0; i < SCENE_COUNT; i++)
+        {
+            scene_rect(i, rect);
+            if(rand() % 200 == 0)
+            {
+                aabb_tree_remove(&tree, leaves[i]);
+                leaves[i] = aabb_tree_insert(&tree, rect, i);
+            }
+            else
+            {
+                aabb_tree_move(&tree, leaves[i], rect);
+                moves++;
+            }
+        }
+    }
+
+    // A random walk of single pixels takes several steps to cross a margin of two
+    CHECK(tree.refits < moves / 2, "%u of %u moves left their fat box\n", tree.refits, moves);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Items inserted in order along a line all pair up with the last one, which without rotations leaves a chain as deep
+// as there are items. Then the scene's items jump across the screen, leaving their leaves where they were, until only
+// the rotations keep the tree in shape.
+static bool test_rotations(void)
+{
+    AabbTree_t tree;
+    float rect[4];
+
+    aabb_tree_init(&tree, MARGIN, nodes, AABB_TREE_NODES(SCENE_COUNT));
+    for(int i = 0; i < SCENE_COUNT; i++)
+    {
+        rect[0] = (float)i;
+        rect[1] = 0.0f;
+        rect[2] = rect[0] + 1.0f;
+        rect[3] = 1.0f;
+        leaves[i] = aabb_tree_insert(&tree, rect, i);
+    }
+    CHECK(tree.rotations > 0, "rotations: none while inserting in order\n");
+    CHECK(depth(&tree, tree.root) <= MAX_DEPTH, "rotations: %d deep after inserting in order\n",
+          depth(&tree, tree.root));
+
+    scene_init();
+    for(int frame = 0; frame < SCENE_FRAMES; frame++)
+    {
+        uint32_t rotations = tree.rotations;
+
+        for(int i = 0; i < SCENE_COUNT; i++)
+        {
+            scene_x[i] = scene_random(SCENE_WIDTH);
+            scene_y[i] = scene_random(SCENE_HEIGHT);
+            scene_rect(i, rect);
+            aabb_tree_move(&tree, leaves[i], rect);
+        }
+        CHECK(tree.rotations > rotations, "rotations: none in frame %d\n", frame);
+        CHECK(depth(&tree, tree.root) <= MAX_DEPTH, "rotations: %d deep in frame %d\n", depth(&tree, tree.root),
+              frame);
+    }
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+int main(void)
+{
+    bool ok = run();
+    ok = test_rotations() && ok;
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
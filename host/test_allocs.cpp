@@ -0,0 +1,60 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "app.h"
+#include "alloc_guard.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Every test binary is app.c or app.cpp compiled for one configuration, see CMakeLists.txt
+#ifndef TEST_ENGINE
+#define TEST_ENGINE                     "?"
+#endif
+
+#define DEFAULT_FRAMES                  600
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+// usage: test_allocs_<engine> [frames]
+// Runs the frame loop like the firmware does and fails if any frame after app_init() allocates, or if the broad phase
+// index ran out of room for a particle, which the static arenas may do instead of allocating
+int main(int argc, char** argv)
+{
+    int frames = (argc > 1) ? atoi(argv[1]) : DEFAULT_FRAMES;
+    uint32_t unindexed = 0;
+
+    alloc_guard_init();
+    app_init();
+    alloc_guard_arm();
+
+    for(int i = 0; i < frames; i++)
+    {
+        app_update();
+        unindexed += app_get_stats()->unindexed;
+    }
+
+    if(alloc_guard_steady() != 0)
+    {
+        fprintf(stderr, "%s: %u allocations in %d steady state frames\n", TEST_ENGINE, 
+                (unsigned)alloc_guard_steady(), frames);
+        return 1;
+    }
+
+    if(unindexed != 0)
+    {
+        fprintf(stderr, "%s: %u particles missing from the broad phase index over %d frames\n", TEST_ENGINE,
+                (unsigned)unindexed, frames);
+        return 1;
+    }
+
+    printf("%s: no allocations in %d steady state frames (%u during init, %u bytes at most)\n", TEST_ENGINE, frames,
+           (unsigned)alloc_guard_total(), (unsigned)alloc_guard_peak_bytes());
+    return 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,223 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "check.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+extern "C" {
+    #include "particles.h"
+    #include "ccd.h"
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define WIDTH                           240
+#define HEIGHT                          320
+#define RADIUS                          2
+#define MIN_DISTANCE                    (2.0f * RADIUS)
+#define DT                              (1.0f / 60)
+
+// The crowd is checked against every pair, so no contact depends on a broad phase
+#define CROWD_COUNT                     100
+#define CROWD_PAIRS                     (CROWD_COUNT * (CROWD_COUNT - 1) / 2)
+#define CROWD_FRAMES                    200
+#define CROWD_SPEED                     2000.0f
+
+#define TOL_POSITION                    1e-3f
+#define TOL_ENERGY                      1e-3
+// How deep two particles may still overlap after a step, rounding in the times of impact only
+#define TOL_OVERLAP                     1e-2f
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+PARTICLES_ALIGNED(static float particle_data[PARTICLES_FLOATS(CROWD_COUNT)]);
+static uint16_t particle_color[CROWD_COUNT];
+static uint32_t ccd_storage[CCD_WORDS(CROWD_COUNT, CROWD_PAIRS)];
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static float random_float(float lo, float hi)
+{
+    return lo + (float)rand() / RAND_MAX * (hi - lo);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void place(ParticleStore_t* store, int i, float x, float y, float vx, float vy)
+{
+    store->x[i] = x;
+    store->y[i] = y;
+    store->vx[i] = vx;
+    store->vy[i] = vy;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static int solve(Ccd_t* ccd, ParticleStore_t* store, float dt)
+{
+    return ccd_solve(ccd, store, dt, MIN_DISTANCE, RADIUS, WIDTH - RADIUS, RADIUS, HEIGHT - RADIUS);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static double kinetic_energy(const ParticleStore_t* store)
+{
+    double energy = 0.0;
+
+    for(int i = 0; i < store->count; i++)
+    {
+        energy += (double)store->vx[i] * store->vx[i] + (double)store->vy[i] * store->vy[i];
+    }
+    return energy;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Two particles closing in by more than their gap plus both diameters in one step: discretely they would end up past
+// each other without ever overlapping
+static bool test_head_on(void)
+{
+    ParticleStore_t store;
+    Ccd_t ccd;
+
+    particles_init(&store, particle_data, particle_color, 2);
+    ccd_init(&ccd, 2, 1, 8, ccd_storage);
+    place(&store, 0, 100.0f, 100.0f, 1000.0f, 0.0f);
+    place(&store, 1, 120.0f, 100.0f, -1000.0f, 0.0f);
+
+    ccd_begin(&ccd);
+    CHECK(ccd_add_pair(&ccd, 0, 1), "head on: no room for the pair\n");
+    CHECK(!ccd_add_pair(&ccd, 0, 1), "head on: pair added past the capacity\n");
+    CHECK(solve(&ccd, &store, DT) == 1, "head on: contact missed\n");
+
+    // They touch at 110 -+ 2 once each has covered 8 pixels, then fly back for the rest of the step
+    float back = 1000.0f * DT - 8.0f;
+
+    CHECK(store.vx[0] == -1000.0f && store.vx[1] == 1000.0f, "head on: velocities not exchanged\n");
+    CHECK(fabsf(store.x[0] - (108.0f - back)) < TOL_POSITION && fabsf(store.x[1] - (112.0f + back)) < TOL_POSITION,
+          "head on: ended at %f and %f\n", store.x[0], store.x[1]);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// A step longer than the distance to the wall is reflected off it at the time it gets there
+static bool test_wall(void)
+{
+    ParticleStore_t store;
+    Ccd_t ccd;
+
+    particles_init(&store, particle_data, particle_color, 1);
+    ccd_init(&ccd, 1, 0, 8, ccd_storage);
+    place(&store, 0, WIDTH - RADIUS - 10.0f, 100.0f, 3000.0f, 0.0f);
+
+    ccd_begin(&ccd);
+    solve(&ccd, &store, DT);
+
+    CHECK(store.vx[0] == -3000.0f, "wall: not reflected\n");
+    CHECK(fabsf(store.x[0] - (WIDTH - RADIUS - (3000.0f * DT - 10.0f))) < TOL_POSITION, "wall: ended at %f\n",
+          store.x[0]);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// A row of resting particles hit at one end: every contact only happens once the previous one has been resolved, and
+// the velocity goes all the way through to the far end within the step
+static bool test_cradle(void)
+{
+    ParticleStore_t store;
+    Ccd_t ccd;
+
+    particles_init(&store, particle_data, particle_color, 3);
+    ccd_init(&ccd, 3, 3, 8, ccd_storage);
+    place(&store, 0, 10.0f, 100.0f, 600.0f, 0.0f);
+    place(&store, 1, 15.0f, 100.0f, 0.0f, 0.0f);
+    place(&store, 2, 20.0f, 100.0f, 0.0f, 0.0f);
+
+    ccd_begin(&ccd);
+    ccd_add_pair(&ccd, 0, 1);
+    ccd_add_pair(&ccd, 1, 2);
+    ccd_add_pair(&ccd, 0, 2);
+    CHECK(solve(&ccd, &store, 0.1f) == 2, "cradle: %u events\n", ccd.events);
+
+    CHECK(store.vx[0] == 0.0f && store.vx[1] == 0.0f && store.vx[2] == 600.0f, "cradle: ended with %f %f %f\n",
+          store.vx[0], store.vx[1], store.vx[2]);
+    CHECK(fabsf(store.x[0] - 11.0f) < TOL_POSITION && fabsf(store.x[1] - 16.0f) < TOL_POSITION &&
+          fabsf(store.x[2] - (20.0f + 600.0f * (0.1f - 2.0f / 600.0f))) < TOL_POSITION,
+          "cradle: ended at %f %f %f\n", store.x[0], store.x[1], store.x[2]);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Particles several diameters a step apart in a closed box without friction: every contact is elastic, so the energy
+// stays what it was, and none of them may end up inside another or outside the walls
+static bool test_crowd(void)
+{
+    ParticleStore_t store;
+    Ccd_t ccd;
+    double energy;
+    int contacts = 0;
+
+    particles_init(&store, particle_data, particle_color, CROWD_COUNT);
+    ccd_init(&ccd, CROWD_COUNT, CROWD_PAIRS, 64 * CROWD_COUNT, ccd_storage);
+    for(int i = 0; i < CROWD_COUNT; i++)
+    {
+        place(&store, i, (float)(10 + (i % 10) * 22), (float)(10 + (i / 10) * 30),
+              random_float(-CROWD_SPEED, CROWD_SPEED), random_float(-CROWD_SPEED, CROWD_SPEED));
+    }
+    energy = kinetic_energy(&store);
+
+    for(int frame = 0; frame < CROWD_FRAMES; frame++)
+    {
+        ccd_begin(&ccd);
+        for(int a = 0; a < CROWD_COUNT; a++)
+        {
+            for(int b = a + 1; b < CROWD_COUNT; b++)
+            {
+                ccd_add_pair(&ccd, a, b);
+            }
+        }
+        contacts += solve(&ccd, &store, DT);
+        CHECK(ccd.events < (uint32_t)ccd.max_events, "crowd: ran out of events in frame %d\n", frame);
+
+        for(int a = 0; a < CROWD_COUNT; a++)
+        {
+            CHECK(store.x[a] >= RADIUS && store.x[a] <= WIDTH - RADIUS && store.y[a] >= RADIUS &&
+                  store.y[a] <= HEIGHT - RADIUS, "crowd: %d left the box in frame %d\n", a, frame);
+            for(int b = a + 1; b < CROWD_COUNT; b++)
+            {
+                float dx = store.x[a] - store.x[b];
+                float dy = store.y[a] - store.y[b];
+
+                CHECK(sqrtf(dx * dx + dy * dy) > MIN_DISTANCE - TOL_OVERLAP,
+                      "crowd: %d and %d overlap in frame %d\n", a, b, frame);
+            }
+        }
+    }
+
+    CHECK(contacts > CROWD_FRAMES, "crowd: only %d contacts\n", contacts);
+    CHECK(fabs(kinetic_energy(&store) - energy) < TOL_ENERGY * energy, "crowd: energy went from %f to %f\n", energy,
+          kinetic_energy(&store));
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+int main(void)
+{
+    srand(1);
+
+    bool ok = test_head_on();
+    ok = test_wall() && ok;
+    ok = test_cradle() && ok;
+    ok = test_crowd() && ok;
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
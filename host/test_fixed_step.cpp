@@ -0,0 +1,75 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "fixed_step.h"
+#include "check.h"
+
+#include <stdio.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// The firmware's schedule: 60 Hz steps on the 1 kHz FreeRTOS tick
+#define RATE                            60
+#define TICK_RATE                       1000
+#define MAX_STEPS                       4
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Waking exactly at every deadline, like vTaskDelayUntil() does when the steps are quick, gives one step per wake and
+// exactly RATE steps per second although a period is 16.67 ticks
+static bool test_on_time(uint32_t start)
+{
+    FixedStep_t clock;
+    fixed_step_init(&clock, RATE, TICK_RATE, MAX_STEPS, start);
+
+    for(int i = 0; i < 10 * RATE; i++)
+    {
+        uint32_t period = clock.deadline;
+        CHECK(fixed_step_due(&clock, clock.deadline - 1) == 0, "on time: step %d due before its deadline\n", i);
+        CHECK(fixed_step_due(&clock, clock.deadline) == 1, "on time: step %d not due at its deadline\n", i);
+        period = clock.deadline - period;
+        CHECK(period == 16 || period == 17, "on time: period of %u ticks\n", (unsigned)period);
+    }
+
+    CHECK(clock.deadline - start == 10 * TICK_RATE + TICK_RATE / RATE, "on time: %u ticks for 10 s\n",
+          (unsigned)(clock.deadline - start));
+    CHECK(clock.overruns == 0 && clock.dropped == 0 && clock.max_late == 0, "on time: overruns counted\n");
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// A wake 40 ticks late owes two more steps, one 200 ticks late more than MAX_STEPS
+static bool test_late(void)
+{
+    FixedStep_t clock;
+    fixed_step_init(&clock, RATE, TICK_RATE, MAX_STEPS, 0);
+
+    CHECK(fixed_step_due(&clock, clock.deadline + 40) == 3, "late: wrong catch up\n");
+    CHECK(clock.overruns == 1 && clock.dropped == 0 && clock.late == 40, "late: overrun not counted\n");
+
+    uint32_t now = clock.deadline + 200;
+    CHECK(fixed_step_due(&clock, now) == MAX_STEPS, "late: catch up not capped\n");
+    CHECK(clock.overruns == 2 && clock.dropped > 0 && clock.max_late == 200, "late: drop not counted\n");
+    CHECK(clock.deadline > now && clock.deadline - now <= 17, "late: schedule not picked up again\n");
+    CHECK(clock.steps == 3 + MAX_STEPS, "late: %u steps handed out\n", (unsigned)clock.steps);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+int main(void)
+{
+    bool ok = test_on_time(0);
+    // The tick counter wraps after 49 days
+    ok = test_on_time(0xFFFFFFFFu - 5000) && ok;
+    ok = test_late() && ok;
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,289 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "vector.hpp"
+#include "check.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+extern "C" {
+    #include "particles.h"
+    #include "rtree.h"
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Same scene as the app defaults
+#define WIDTH                           240
+#define HEIGHT                          320
+#define RADIUS                          6
+#define COUNT                           80
+#define PITCH                           28
+
+#define RANDOM_CASES                    100000
+#define TRAJECTORY_FRAMES               20
+#define DT                              (1.0f / 60)
+
+// Tolerances against the double precision reference, in pixels and pixels per step. Contacts amplify rounding
+// differences, so the trajectory is kept short enough that the two runs still resolve the same pairs.
+#define TOL_VECTOR                      1e-5
+#define TOL_CONTACT                     1e-4
+#define TOL_TRAJECTORY                  1e-2
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+typedef struct RefParticle_s
+{
+    double x, y, vx, vy, ax, ay;
+}RefParticle_t;
+
+typedef struct Hits_s
+{
+    int count;
+    bool hit[COUNT];
+}Hits_t;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+PARTICLES_ALIGNED(static float particle_data[PARTICLES_FLOATS(COUNT)]);
+static uint16_t particle_color[COUNT];
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static double frand(double lo, double hi)
+{
+    return lo + (hi - lo) * rand() / RAND_MAX;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The response as it was written before the single precision work: rotate into the contact frame with atan2/sin/cos,
+// swap the normal components, rotate back. Everything in double.
+static bool reference_collide(RefParticle_t* a, RefParticle_t* b, double min_distance)
+{
+    double dx = a->x - b->x;
+    double dy = a->y - b->y;
+    double dist = sqrt(dx * dx + dy * dy);
+    if(dist >= min_distance || dist == 0.0)
+        return false;
+
+    double correction = (min_distance - dist) / 2.0;
+    a->x += dx / dist * correction;
+    a->y += dy / dist * correction;
+    b->x -= dx / dist * correction;
+    b->y -= dy / dist * correction;
+
+    double theta = atan2(a->y - b->y, a->x - b->x);
+    double sine = sin(theta);
+    double cosine = cos(theta);
+
+    double a_n = cosine * a->vx + sine * a->vy, a_t = cosine * a->vy - sine * a->vx;
+    double b_n = cosine * b->vx + sine * b->vy, b_t = cosine * b->vy - sine * b->vx;
+
+    a->vx = cosine * b_n - sine * a_t;
+    a->vy = cosine * a_t + sine * b_n;
+    b->vx = cosine * a_n - sine * b_t;
+    b->vy = cosine * b_t + sine * a_n;
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void reference_step_axis(double* p, double* v, double a, double lo, double hi)
+{
+    *v *= 1.0 - a * DT;
+    *p += *v * DT;
+    if(*p > hi)
+    {
+        *p = hi;
+        *v = -*v;
+    }
+    else if(*p < lo)
+    {
+        *p = lo;
+        *v = -*v;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool collect_hit(const rtree_coord_t* rect, const void* item, void* udata)
+{
+    Hits_t* hits = (Hits_t*)udata;
+    hits->hit[*(const int*)item] = true;
+    hits->count++;
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool test_vector(void)
+{
+    for(int i = 0; i < RANDOM_CASES; i++)
+    {
+        double x = frand(-WIDTH, WIDTH), y = frand(-HEIGHT, HEIGHT);
+        PVector v((float)x, (float)y);
+        double mag = sqrt((double)v.x * v.x + (double)v.y * v.y);
+
+        CHECK(fabs(v.mag() - mag) <= TOL_VECTOR * mag, "PVector::mag(%f, %f) = %f, expected %f\n", x, y, v.mag(), mag);
+        CHECK(fabs(v.heading() - atan2((double)v.y, (double)v.x)) <= TOL_VECTOR,
+              "PVector::heading(%f, %f) = %f, expected %f\n", x, y, v.heading(), atan2(y, x));
+    }
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool test_contact(void)
+{
+    ParticleStore_t store;
+    particles_init(&store, particle_data, particle_color, 2);
+
+    for(int i = 0; i < RANDOM_CASES; i++)
+    {
+        RefParticle_t ref[2];
+        for(int k = 0; k < 2; k++)
+        {
+            store.x[k] = (float)frand(0, 3 * RADIUS);
+            store.y[k] = (float)frand(0, 3 * RADIUS);
+            store.vx[k] = (float)frand(-4, 4);
+            store.vy[k] = (float)frand(-4, 4);
+            ref[k].x = store.x[k];
+            ref[k].y = store.y[k];
+            ref[k].vx = store.vx[k];
+            ref[k].vy = store.vy[k];
+        }
+
+        bool hit = particles_collide(&store, 0, 1, 2 * RADIUS);
+        bool ref_hit = reference_collide(&ref[0], &ref[1], 2 * RADIUS);
+
+        // A pair sitting right on the contact distance may round either way
+        double dist = hypot(ref[0].x - ref[1].x, ref[0].y - ref[1].y);
+        if(hit != ref_hit && fabs(dist - 2 * RADIUS) < TOL_CONTACT)
+            continue;
+
+        CHECK(hit == ref_hit, "contact %d: float says %d, double says %d\n", i, hit, ref_hit);
+        for(int k = 0; k < 2; k++)
+        {
+            CHECK(fabs(store.x[k] - ref[k].x) <= TOL_CONTACT && fabs(store.y[k] - ref[k].y) <= TOL_CONTACT &&
+                  fabs(store.vx[k] - ref[k].vx) <= TOL_CONTACT && fabs(store.vy[k] - ref[k].vy) <= TOL_CONTACT,
+                  "contact %d: particle %d is off by (%g, %g, %g, %g)\n", i, k, store.x[k] - ref[k].x,
+                  store.y[k] - ref[k].y, store.vx[k] - ref[k].vx, store.vy[k] - ref[k].vy);
+        }
+    }
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The float rects the app queries with must find exactly what an exact intersection test finds
+static bool test_rtree_query(void)
+{
+    static float x[COUNT], y[COUNT];
+    struct rtree* tr = rtree_new(sizeof(int), 2);
+
+    for(int i = 0; i < COUNT; i++)
+    {
+        x[i] = (float)frand(RADIUS, WIDTH - RADIUS);
+        y[i] = (float)frand(RADIUS, HEIGHT - RADIUS);
+        rtree_coord_t rect[] = { x[i] - RADIUS, y[i] - RADIUS, x[i] + RADIUS, y[i] + RADIUS };
+        rtree_insert(tr, rect, &i);
+    }
+
+    for(int i = 0; i < COUNT; i++)
+    {
+        rtree_coord_t rect[] = { x[i] - 2 * RADIUS, y[i] - 2 * RADIUS, x[i] + 2 * RADIUS, y[i] + 2 * RADIUS };
+        Hits_t hits = {};
+        rtree_search(tr, rect, collect_hit, &hits);
+
+        int expected = 0;
+        for(int j = 0; j < COUNT; j++)
+        {
+            // Compared in double against the rects exactly as they were stored
+            rtree_coord_t item[] = { x[j] - RADIUS, y[j] - RADIUS, x[j] + RADIUS, y[j] + RADIUS };
+            bool overlap = !((double)item[2] < (double)rect[0] || (double)item[0] > (double)rect[2] ||
+                             (double)item[3] < (double)rect[1] || (double)item[1] > (double)rect[3]);
+            CHECK(overlap == hits.hit[j], "query %d: particle %d %s\n", i, j, overlap ? "missed" : "reported");
+            expected += overlap;
+        }
+        CHECK(hits.count == expected, "query %d: %d hits, expected %d\n", i, hits.count, expected);
+    }
+
+    rtree_free(tr);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// A short run of the app scene, integrate plus an all-pairs narrow phase, against the same steps in double
+static bool test_trajectory(void)
+{
+    static RefParticle_t ref[COUNT];
+    ParticleStore_t store;
+    particles_init(&store, particle_data, particle_color, COUNT);
+
+    for(int i = 0; i < COUNT; i++)
+    {
+        store.x[i] = RADIUS + (i % (WIDTH / PITCH)) * PITCH;
+        store.y[i] = RADIUS + (i / (WIDTH / PITCH)) * PITCH;
+        store.vx[i] = (float)frand(-200, 200);
+        store.vy[i] = (float)frand(-200, 200);
+        store.ax[i] = 0.1f / (1 + rand() % 9);
+        store.ay[i] = 0.1f / (1 + rand() % 9);
+        ref[i] = (RefParticle_t){ store.x[i], store.y[i], store.vx[i], store.vy[i], store.ax[i], store.ay[i] };
+    }
+
+    int contacts = 0;
+    for(int frame = 0; frame < TRAJECTORY_FRAMES; frame++)
+    {
+        particles_integrate(&store, DT, RADIUS, WIDTH - RADIUS, RADIUS, HEIGHT - RADIUS);
+        for(int i = 0; i < COUNT; i++)
+        {
+            reference_step_axis(&ref[i].x, &ref[i].vx, ref[i].ax, RADIUS, WIDTH - RADIUS);
+            reference_step_axis(&ref[i].y, &ref[i].vy, ref[i].ay, RADIUS, HEIGHT - RADIUS);
+        }
+
+        for(int a = 0; a < COUNT; a++)
+        {
+            for(int b = a + 1; b < COUNT; b++)
+            {
+                bool hit = particles_collide(&store, a, b, 2 * RADIUS);
+                bool ref_hit = reference_collide(&ref[a], &ref[b], 2 * RADIUS);
+                CHECK(hit == ref_hit, "frame %d: pair %d/%d float says %d, double says %d\n", frame, a, b, hit, ref_hit);
+                contacts += hit;
+            }
+        }
+
+        for(int i = 0; i < COUNT; i++)
+        {
+            CHECK(fabs(store.x[i] - ref[i].x) <= TOL_TRAJECTORY && fabs(store.y[i] - ref[i].y) <= TOL_TRAJECTORY,
+                  "frame %d: particle %d at (%f, %f), expected (%f, %f)\n", frame, i, store.x[i], store.y[i],
+                  ref[i].x, ref[i].y);
+        }
+    }
+
+    // The run must actually exercise the collision response
+    CHECK(contacts > 0, "trajectory: no contacts in %d frames\n", TRAJECTORY_FRAMES);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Single precision math against the double precision behaviour it replaced
+int main(void)
+{
+    srand(1);
+
+    bool ok = test_vector();
+    ok = test_contact() && ok;
+    ok = test_rtree_query() && ok;
+    ok = test_trajectory() && ok;
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "profiler.h"
+#include "check.h"
+
+#include <stdio.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Frames 1 to 100 in shuffled order, the time of a frame split over two calls
+static bool test_stats(void)
+{
+    ProfileStats_t stats;
+
+    profiler_init();
+    profiler_stats(PROFILE_DRAW, &stats);
+    CHECK(stats.frames == 0 && stats.max == 0, "stats: figures without frames\n");
+
+    for(uint32_t i = 0; i < 100; i++)
+    {
+        uint32_t sample = (i * 37) % 100 + 1;
+        profiler_add(PROFILE_DRAW, sample / 2);
+        profiler_add(PROFILE_DRAW, sample - sample / 2);
+        profiler_end_frame(PROFILE_ERASE, PROFILE_SLEEP);
+    }
+
+    profiler_stats(PROFILE_DRAW, &stats);
+    CHECK(stats.frames == 100, "stats: %u frames\n", (unsigned)stats.frames);
+    CHECK(stats.min == 1 && stats.max == 100, "stats: range %u to %u\n", (unsigned)stats.min, (unsigned)stats.max);
+    CHECK(stats.avg == 50, "stats: average of %u\n", (unsigned)stats.avg);
+    CHECK(stats.p99 == 99, "stats: p99 of %u\n", (unsigned)stats.p99);
+
+    // Closed with the draw phase but never added to
+    profiler_stats(PROFILE_SLEEP, &stats);
+    CHECK(stats.frames == 100 && stats.max == 0, "stats: idle phase got time\n");
+    // Belongs to the other task, never closed
+    profiler_stats(PROFILE_INTEGRATE, &stats);
+    CHECK(stats.frames == 0, "stats: phase closed by the wrong frame\n");
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Old frames leave the ring, a single slow one is the max but not the p99
+static bool test_history(void)
+{
+    ProfileStats_t stats;
+
+    profiler_init();
+    for(uint32_t i = 0; i < 3 * PROFILE_HISTORY; i++)
+    {
+        profiler_add(PROFILE_TREE, (i < 2 * PROFILE_HISTORY) ? 1000 : 10);
+        profiler_end_frame(PROFILE_INTEGRATE, PROFILE_NARROW_PHASE);
+    }
+    profiler_add(PROFILE_TREE, 500);
+    profiler_end_frame(PROFILE_INTEGRATE, PROFILE_NARROW_PHASE);
+
+    profiler_stats(PROFILE_TREE, &stats);
+    CHECK(stats.frames == PROFILE_HISTORY, "history: %u frames\n", (unsigned)stats.frames);
+    CHECK(stats.min == 10 && stats.max == 500, "history: range %u to %u\n", (unsigned)stats.min,
+          (unsigned)stats.max);
+    CHECK(stats.p99 == 10, "history: p99 of %u\n", (unsigned)stats.p99);
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+int main(void)
+{
+    bool ok = test_stats();
+    ok = test_history() && ok;
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
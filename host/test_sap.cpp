@@ -0,0 +1,67 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "sap.h"
+#include "check.h"
+#include "scene.h"
+
+#include <stdio.h>
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static SapEndpoint_t endpoints[SAP_ENDPOINTS(SCENE_COUNT)];
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static bool collect(int a, int b, void* udata)
+{
+    return scene_add_pair((PairSet_t*)udata, a, b);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool run(const char* name, int capacity, bool expect_tracking)
+{
+    SapPair_t* pairs = new SapPair_t[capacity];
+    uint16_t* slots = new uint16_t[SAP_SLOTS(capacity)];
+    Sap_t sap;
+    bool tracked = false;
+
+    scene_init();
+    sap_init(&sap, SCENE_EXTENT, endpoints, pairs, capacity, slots);
+    for(int frame = 0; frame < SCENE_FRAMES; frame++)
+    {
+        PairSet_t found;
+
+        sap_update(&sap, scene_y, scene_x, sizeof(float), SCENE_COUNT);
+        CHECK(sap_pairs(&sap, collect, &found), "%s: pair reported twice in frame %d\n", name, frame);
+        CHECK(found == scene_brute_force_pairs(), "%s: %d pairs instead of %d in frame %d\n", name,
+              (int)found.size(), (int)scene_brute_force_pairs().size(), frame);
+        tracked = tracked || sap.tracking;
+
+        scene_step(frame);
+    }
+
+    CHECK(tracked == expect_tracking, "%s: pair set %s\n", name, tracked ? "used" : "never used");
+    delete[] pairs;
+    delete[] slots;
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+int main(void)
+{
+    bool ok = run("tracked", 8 * SCENE_COUNT, true);
+    // Too small for the overlaps, every step falls back to sweeping
+    ok = run("overflow", 16, false) && ok;
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,41 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "utils.h"
+#include <time.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void delayMiliSecs(uint32_t ms_)
+{
+    // The host runs frames back to back, pacing only matters on the display
+    (void)ms_;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void cycle_counter_init(void)
+{
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// No cycle counter to read, the monotonic clock stands in for it with one count per nanosecond
+uint32_t cycle_counter_read(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t cycle_counter_rate(void)
+{
+    return 1000000000u;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint16_t cpu_usage(void)
+{
+    return 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,124 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "hud.h"
+#include "display.h"
+#include "lcd_dma2d.h"
+#include "stm32f429i_discovery_lcd.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define HUD_FONT                        Font8x12
+#define HUD_COLUMNS                     (LCD_PIXEL_WIDTH / HUD_GLYPH_WIDTH)
+
+// Everything the HUD prints but spaces, which are just the background
+#define HUD_CHARSET                     "%-./0123456789:abcdefghijklmnopqrstuvwxyz"
+#define HUD_GLYPHS                      (sizeof(HUD_CHARSET) - 1)
+#define HUD_ATLAS_WIDTH                 (HUD_GLYPHS * HUD_GLYPH_WIDTH)
+
+#define NO_GLYPH                        0xFF
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+// The glyphs side by side, one row of pixels of each after the other
+static uint16_t atlas[HUD_GLYPH_HEIGHT * HUD_ATLAS_WIDTH];
+// Atlas slot of every ASCII character, NO_GLYPH for the ones left out
+static uint8_t glyph_index[128];
+static uint16_t hud_lines;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Same bit order as LCD_DrawChar(): fonts up to 12 pixels wide keep a row in the high bits of its byte or two, wider
+// ones start at bit 0
+static void expand_glyph(int slot, char character)
+{
+    const uint16_t* rows = &HUD_FONT.table[(character - ' ') * HUD_FONT.Height];
+
+    for(int y = 0; y < HUD_GLYPH_HEIGHT; y++)
+    {
+        for(int x = 0; x < HUD_GLYPH_WIDTH; x++)
+        {
+            uint16_t mask = (HUD_FONT.Width <= 12) ? (uint16_t)((0x80 << ((HUD_FONT.Width / 12) * 8)) >> x)
+                                                   : (uint16_t)(1 << x);
+
+            atlas[slot * HUD_GLYPH_WIDTH + x + HUD_ATLAS_WIDTH * y] = (rows[y] & mask) ? HUD_TEXT_COLOR
+                                                                                         : HUD_BACK_COLOR;
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void hud_init(uint16_t lines)
+{
+    for(int i = 0; i < 128; i++)
+    {
+        glyph_index[i] = NO_GLYPH;
+    }
+    for(int slot = 0; slot < (int)HUD_GLYPHS; slot++)
+    {
+        glyph_index[(int)HUD_CHARSET[slot]] = (uint8_t)slot;
+        expand_glyph(slot, HUD_CHARSET[slot]);
+    }
+    
+    hud_lines = lines;
+    display_overlay_init(lines * HUD_GLYPH_HEIGHT);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void hud_begin(void)
+{
+    display_begin_overlay();
+    lcd_dma2d_fill(0, 0, LCD_PIXEL_WIDTH, hud_lines * HUD_GLYPH_HEIGHT, HUD_BACK_COLOR);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The overlay is ARGB4444 but the DMA2D is told RGB565 like for the frame: both are two bytes a pixel, the copies and
+// fills move the bits untouched
+void hud_print(uint16_t column, uint16_t line, const char* text)
+{
+    if(line >= hud_lines)
+        return;
+    
+    for(; column < HUD_COLUMNS && *text; column++, text++)
+    {
+        uint8_t character = (uint8_t)*text;
+        uint8_t slot = (character < 128) ? glyph_index[character] : NO_GLYPH;
+        
+        // The band is already cleared to the background
+        if(slot == NO_GLYPH)
+            continue;
+        
+        lcd_dma2d_copy(column * HUD_GLYPH_WIDTH, line * HUD_GLYPH_HEIGHT, HUD_GLYPH_WIDTH, HUD_GLYPH_HEIGHT,
+                       &atlas[slot * HUD_GLYPH_WIDTH], HUD_ATLAS_WIDTH);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void hud_printf(uint16_t column, uint16_t line, const char* format, ...)
+{
+    char text[HUD_COLUMNS + 1];
+    va_list args;
+    
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    
+    hud_print(column, line, text);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void hud_end(void)
+{
+    display_end_overlay();
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,44 @@
+#ifndef __HUD_H
+#define __HUD_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Font8x12 cells, 30 of them to a line
+#define HUD_GLYPH_WIDTH                 8
+#define HUD_GLYPH_HEIGHT                12
+
+// ARGB4444, the text over a half transparent band
+#define HUD_TEXT_COLOR                  0xFFFF
+#define HUD_BACK_COLOR                  0x8000
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Lines of text on the display overlay. Every glyph is expanded once into an ARGB4444 atlas, so printing a character is
+// a single lcd_dma2d copy instead of the LCD driver setting its pixels one by one. Only the characters the HUD needs
+// are in the atlas: digits, lowercase letters and "%-./:", anything else is left blank like a space.
+// hud_init() sets up the overlay and must run before display_init(). A refresh goes between display_begin_frame() and
+// display_present(): hud_begin() clears the band, hud_print() writes text from a character cell on, cut at the end of
+// the line, and hud_end() has it all shown.
+void hud_init(uint16_t lines);
+void hud_begin(void);
+void hud_print(uint16_t column, uint16_t line, const char* text);
+void hud_printf(uint16_t column, uint16_t line, const char* format, ...);
+void hud_end(void);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HUD_H */
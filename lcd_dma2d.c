@@ -0,0 +1,224 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <assert.h>
+#include <stdbool.h>
+#include "global_includes.h"
+#include "lcd_dma2d.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Commands waiting for the DMA2D, a power of two so the free running counters wrap cleanly
+#define LCD_DMA2D_QUEUE_SIZE            32
+
+#define FENCE_REACHED(fence)            ((int32_t)(completed - (fence)) >= 0)
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Everything the DMA2D registers need, the frame buffer address is resolved when the command is queued
+typedef struct
+{
+    uint32_t mode;                      // DMA2D_R2M, DMA2D_M2M or DMA2D_M2M_BLEND
+    uint32_t output;
+    uint32_t source;
+    uint32_t color;                     // RGB565 output color for fills, RGB888 foreground color for blends
+    uint16_t source_offset;
+    uint16_t width;
+    uint16_t height;
+} Command_t;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static Command_t queue[LCD_DMA2D_QUEUE_SIZE];
+// Commands ever queued and ever finished. The first is only written by tasks, the second only by the interrupt, and
+// the command at completed is the one the DMA2D is running whenever they differ.
+static volatile uint32_t submitted;
+static volatile uint32_t completed;
+static TaskHandle_t waiter;
+static uint32_t waiter_fence;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Writes the registers directly, going through DMA2D_DeInit() and DMA2D_Init() is too slow for the interrupt. A
+// command that fails ends in an error interrupt instead of a transfer complete, so both are enabled. The LCD driver's
+// blocking primitives leave their transfer complete flag set, and enabling the interrupts with it still there would
+// retire this command before the DMA2D even started it, so the flags are cleared first.
+static void start(const Command_t* command)
+{
+    DMA2D->IFCR = DMA2D_IFSR_CTCIF | DMA2D_IFSR_CTEIF | DMA2D_IFSR_CCEIF;
+    DMA2D->CR = command->mode | DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE;
+    DMA2D->OPFCCR = DMA2D_RGB565;
+    DMA2D->OMAR = command->output;
+    DMA2D->OOR = LCD_PIXEL_WIDTH - command->width;
+    DMA2D->NLR = ((uint32_t)command->width << 16) | command->height;
+
+    switch(command->mode)
+    {
+    case DMA2D_R2M:
+        DMA2D->OCOLR = command->color;
+        break;
+    case DMA2D_M2M:
+        DMA2D->FGMAR = command->source;
+        DMA2D->FGOR = command->source_offset;
+        DMA2D->FGPFCCR = DMA2D_RGB565;
+        break;
+    case DMA2D_M2M_BLEND:
+        // The A8 mask only carries alpha, the DMA2D takes the color from FGCOLR and blends over the frame buffer
+        DMA2D->FGMAR = command->source;
+        DMA2D->FGOR = command->source_offset;
+        DMA2D->FGPFCCR = CM_A8;
+        DMA2D->FGCOLR = command->color;
+        DMA2D->BGMAR = command->output;
+        DMA2D->BGOR = LCD_PIXEL_WIDTH - command->width;
+        DMA2D->BGPFCCR = DMA2D_RGB565;
+        break;
+    }
+
+    DMA2D->CR |= DMA2D_CR_START;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void enqueue(uint32_t mode, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint32_t source,
+                    uint16_t source_width, uint32_t color)
+{
+    Command_t* command;
+
+    // The DMA2D rejects empty transfers with a configuration error
+    if(width == 0 || height == 0)
+        return;
+
+    // Full ring, wait for the oldest command to leave it
+    if(submitted - completed == LCD_DMA2D_QUEUE_SIZE)
+        lcd_dma2d_wait_fence(submitted - LCD_DMA2D_QUEUE_SIZE + 1);
+
+    command = &queue[submitted % LCD_DMA2D_QUEUE_SIZE];
+    command->mode = mode;
+    command->output = LCD_SetCursor(x, y);
+    command->source = source;
+    command->color = color;
+    command->source_offset = source_width - width;
+    command->width = width;
+    command->height = height;
+
+    // An empty ring means the interrupt has nothing left to chain, so the first command is started here
+    taskENTER_CRITICAL();
+    if(submitted++ == completed)
+        start(command);
+    taskEXIT_CRITICAL();
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static uint32_t rgb565_to_rgb888(uint16_t color)
+{
+    uint32_t red = (color >> 11) & 0x1F;
+    uint32_t green = (color >> 5) & 0x3F;
+    uint32_t blue = color & 0x1F;
+
+    return ((red << 3 | red >> 2) << 16) | ((green << 2 | green >> 4) << 8) | (blue << 3 | blue >> 2);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void lcd_dma2d_init(void)
+{
+    DMA2D->IFCR = DMA2D_IFSR_CTCIF | DMA2D_IFSR_CTEIF | DMA2D_IFSR_CCEIF;
+    NVIC_SetPriority(DMA2D_IRQn, GRAPHICS_IRQ_PRIORITY);
+    NVIC_EnableIRQ(DMA2D_IRQn);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_clear(uint16_t color)
+{
+    enqueue(DMA2D_R2M, 0, 0, LCD_PIXEL_WIDTH, LCD_PIXEL_HEIGHT, 0, LCD_PIXEL_WIDTH, color);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_fill(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t color)
+{
+    enqueue(DMA2D_R2M, x, y, width, height, 0, width, color);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_copy(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t* source,
+                    uint16_t source_width)
+{
+    enqueue(DMA2D_M2M, x, y, width, height, (uint32_t)source, source_width, 0);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_blend(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* alpha,
+                     uint16_t source_width, uint16_t color)
+{
+    enqueue(DMA2D_M2M_BLEND, x, y, width, height, (uint32_t)alpha, source_width, rgb565_to_rgb888(color));
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t lcd_dma2d_fence(void)
+{
+    return submitted;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_wait_fence(uint32_t fence)
+{
+    for(;;)
+    {
+        // The interrupt is masked while the waiter is registered, so the notification cannot slip in between
+        taskENTER_CRITICAL();
+        bool reached = FENCE_REACHED(fence);
+        if(!reached)
+        {
+            waiter = xTaskGetCurrentTaskHandle();
+            waiter_fence = fence;
+        }
+        taskEXIT_CRITICAL();
+
+        if(reached)
+            return;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_wait(void)
+{
+    lcd_dma2d_wait_fence(submitted);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void lcd_dma2d_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    if((DMA2D->ISR & (DMA2D_ISR_TCIF | DMA2D_ISR_TEIF | DMA2D_ISR_CEIF)) == 0)
+        return;
+    // A stale flag would count a command as done while the DMA2D is still running it, or with none queued at all
+    assert(completed != submitted && (DMA2D->CR & DMA2D_CR_START) == 0);
+
+    // A bad address or an unaligned source stops the command with an error, the DMA2D is idle again either way. The
+    // failed command is retired like a finished one: what it drew is lost, but the ring keeps moving and no fence
+    // waits on it forever.
+    DMA2D->IFCR = DMA2D_IFSR_CTCIF | DMA2D_IFSR_CTEIF | DMA2D_IFSR_CCEIF;
+    completed++;
+
+    // Chain the next command straight away, the DMA2D never waits for a task to be scheduled
+    if(completed != submitted)
+        start(&queue[completed % LCD_DMA2D_QUEUE_SIZE]);
+
+    if(waiter && FENCE_REACHED(waiter_fence))
+    {
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        waiter = NULL;
+    }
+    portYIELD_FROM_ISR(woken);
+}
+// ---------------------------------------------------------------------------------------------------------------------
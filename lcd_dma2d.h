@@ -0,0 +1,45 @@
+#ifndef __LCD_DMA2D_H
+#define __LCD_DMA2D_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Queued DMA2D operations on the frame buffer the LCD driver currently draws into. Each one goes into a ring and
+// returns right away, the DMA2D interrupt starts the next as soon as the previous is done, so a frame's worth of fills,
+// copies and blends runs back to back while the CPU does something else. Only a full ring makes the caller wait.
+// Sources must stay untouched until the operation is done, and must not be in the CCM data RAM, which the DMA2D cannot
+// reach. lcd_dma2d_fence() marks everything queued so far and lcd_dma2d_wait_fence() blocks the calling task until the
+// DMA2D got past it, lcd_dma2d_wait() waits for all of it. The driver's own drawing, including its blocking DMA2D
+// primitives, must not run before that. Only one task may wait. An operation the DMA2D rejects with an error is dropped
+// and counts as done.
+void lcd_dma2d_init(void);
+void lcd_dma2d_clear(uint16_t color);
+void lcd_dma2d_fill(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t color);
+// RGB565 source, source_width pixels per row
+void lcd_dma2d_copy(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t* source,
+                    uint16_t source_width);
+// A8 coverage mask, source_width bytes per row, painted with color over what the frame buffer holds
+void lcd_dma2d_blend(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* alpha,
+                     uint16_t source_width, uint16_t color);
+uint32_t lcd_dma2d_fence(void);
+void lcd_dma2d_wait_fence(uint32_t fence);
+void lcd_dma2d_wait(void);
+
+// Target only, called from DMA2D_IRQHandler
+void lcd_dma2d_isr(void);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCD_DMA2D_H */
@@ -3,6 +3,8 @@
 // ---------------------------------------------------------------------------------------------------------------------
 #include "global_includes.h"
 #include "app.h"
+#include "alloc_guard.h"
+#include "fixed_step.h"
 #include <stdlib.h>
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -11,15 +13,29 @@
 #define Background_Task_PRIO    ( tskIDLE_PRIORITY  + 10 )
 #define Background_Task_STACK   ( 512 )
 
-#define Demo_Task_PRIO          ( tskIDLE_PRIORITY  + 9 )
-#define Demo_Task_STACK         ( 3048 )
+// Physics outranks rendering so its steps keep their pace, rendering takes whatever time is left
+#define Physics_Task_PRIO       ( tskIDLE_PRIORITY  + 9 )
+#define Physics_Task_STACK      ( 3048 )
+
+#define Render_Task_PRIO        ( tskIDLE_PRIORITY  + 8 )
+#define Render_Task_STACK       ( 1024 )
+
+// Steps a late physics task may catch up on at once, past that they are dropped rather than starving the render task
+#define PHYSICS_MAX_CATCH_UP    ( 4 )
 
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 xTaskHandle                   Task_Handle;
 xTaskHandle                   Demo_Handle;
+xTaskHandle                   Render_Handle;
 xTimerHandle                  TouchScreenTimer;
 
+StackType_t    render_stack_memory[Render_Task_STACK];
+StaticTask_t   render_task_buffer;
+
+// Step count, overruns, drops and lateness of the physics schedule, to be looked at with the debugger
+FixedStep_t    physics_clock;
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Private functions
 // ---------------------------------------------------------------------------------------------------------------------
@@ -44,22 +60,53 @@ static void initialize_peripherals(void)
     /* Enable the LTDC */
     LTDC_Cmd(ENABLE);
     
-    /* Set LCD Background Layer  */
-    LCD_SetLayer(LCD_FOREGROUND_LAYER);
+    /* Set LCD Background Layer, the foreground one is left to the overlay */
+    LCD_SetLayer(LCD_BACKGROUND_LAYER);
     
     /* Clear the Background Layer */ 
     LCD_Clear(LCD_COLOR_WHITE);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
-static void Demo_Task(void * pvParameters)
+static void Render_Task(void * pvParameters)
+{
+    // Paced by the display, every frame shows the latest snapshot the physics task published
+    while (1)
+    {
+        app_render();
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void Physics_Task(void * pvParameters)
 {  
     initialize_peripherals();
+    alloc_guard_init();
     app_init();
     
+    Render_Handle = xTaskCreateStatic(Render_Task, 
+                                      (char const*)"RENDER", 
+                                      Render_Task_STACK, 
+                                      NULL, 
+                                      Render_Task_PRIO, 
+                                      render_stack_memory, 
+                                      &render_task_buffer);
+    
+    // From here on a frame must not allocate, alloc_guard_steady() counts the ones that still do
+    alloc_guard_arm();
+    
+    // Steps while the render task draws the previous one, the snapshots between them need no lock. vTaskDelayUntil()
+    // counts from the last wake instead of from now, so the time the steps take does not stretch the period.
+    TickType_t wake = xTaskGetTickCount();
+    fixed_step_init(&physics_clock, APP_SIMULATION_RATE, configTICK_RATE_HZ, PHYSICS_MAX_CATCH_UP, wake);
     while (1)
     {
-        app_update();
+        vTaskDelayUntil(&wake, physics_clock.deadline - wake);
+        
+        for (uint32_t steps = fixed_step_due(&physics_clock, xTaskGetTickCount()); steps > 0; steps--)
+        {
+            app_simulate();
+        }
     }
 }
 
@@ -75,21 +122,21 @@ const HeapRegion_t xHeapRegions[] =
     { NULL, 0 } /* Terminates the array. */
 };
 
-StackType_t    demo_stack_memory[Demo_Task_STACK];
-StaticTask_t   demo_task_buffer;
+StackType_t    physics_stack_memory[Physics_Task_STACK];
+StaticTask_t   physics_task_buffer;
 
 int main(void)
 {
   vPortDefineHeapRegions(xHeapRegions);
     
  
-   xTaskCreateStatic(Demo_Task, 
-                     (char const*)"GUI_DEMO", 
-                     Demo_Task_STACK, 
+   xTaskCreateStatic(Physics_Task, 
+                     (char const*)"PHYSICS", 
+                     Physics_Task_STACK, 
                      NULL, 
-                     Demo_Task_PRIO, 
-                     demo_stack_memory, 
-                     &demo_task_buffer);
+                     Physics_Task_PRIO, 
+                     physics_stack_memory, 
+                     &physics_task_buffer);
 
 
   /* Start the FreeRTOS scheduler */
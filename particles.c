@@ -0,0 +1,210 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "particles.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+// One axis of one particle over dt seconds: apply the friction of the previous step, move, and bounce off the walls.
+// Applying the damping first instead of last keeps the collision response seeing the same undamped velocities as before.
+static inline void step_axis(float* p, float* v, const float* a, int i, float lo, float hi, float dt)
+{
+    float vel = v[i] * (1.0f - a[i] * dt);
+    float pos = p[i] + vel * dt;
+
+    if(pos > hi)
+    {
+        pos = hi;
+        vel = -vel;
+    }
+    else if(pos < lo)
+    {
+        pos = lo;
+        vel = -vel;
+    }
+
+    p[i] = pos;
+    v[i] = vel;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+#if defined(__SSE2__)
+static inline void step_axis_x4(float* p, float* v, const float* a, __m128 lo, __m128 hi, __m128 dt)
+{
+    __m128 vel = _mm_mul_ps(_mm_load_ps(v), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_load_ps(a), dt)));
+    __m128 pos = _mm_add_ps(_mm_load_ps(p), _mm_mul_ps(vel, dt));
+    __m128 out = _mm_or_ps(_mm_cmpgt_ps(pos, hi), _mm_cmplt_ps(pos, lo));
+
+    _mm_store_ps(p, _mm_min_ps(_mm_max_ps(pos, lo), hi));
+    _mm_store_ps(v, _mm_xor_ps(vel, _mm_and_ps(out, _mm_set1_ps(-0.0f))));
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#elif defined(__ARM_NEON)
+static inline void step_axis_x4(float* p, float* v, const float* a, float32x4_t lo, float32x4_t hi, float32x4_t dt)
+{
+    float32x4_t vel = vmulq_f32(vld1q_f32(v), vsubq_f32(vdupq_n_f32(1.0f), vmulq_f32(vld1q_f32(a), dt)));
+    float32x4_t pos = vaddq_f32(vld1q_f32(p), vmulq_f32(vel, dt));
+    uint32x4_t out = vorrq_u32(vcgtq_f32(pos, hi), vcltq_f32(pos, lo));
+
+    vst1q_f32(p, vminq_f32(vmaxq_f32(pos, lo), hi));
+    vst1q_f32(v, vbslq_f32(out, vnegq_f32(vel), vel));
+}
+// ---------------------------------------------------------------------------------------------------------------------
+#endif
+
+// Exchanges the velocity components along the unit normal from b to a, which is the elastic response for equal masses
+static void exchange_normal(ParticleStore_t* store, int a, int b, float nx, float ny)
+{
+    float dvn = (store->vx[b] - store->vx[a]) * nx + (store->vy[b] - store->vy[a]) * ny;
+
+    store->vx[a] += dvn * nx;
+    store->vy[a] += dvn * ny;
+    store->vx[b] -= dvn * nx;
+    store->vy[b] -= dvn * ny;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void particles_init(ParticleStore_t* store, float* data, uint16_t* color, int count)
+{
+    int capacity = PARTICLES_CAPACITY(count);
+
+    store->count = count;
+    store->x = data;
+    store->y = data + capacity;
+    store->vx = data + 2 * capacity;
+    store->vy = data + 3 * capacity;
+    store->ax = data + 4 * capacity;
+    store->ay = data + 5 * capacity;
+    store->color = color;
+
+    for(int i = 0; i < PARTICLES_FLOATS(count); i++)
+    {
+        data[i] = 0.0f;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void particles_integrate(ParticleStore_t* store, float dt, float min_x, float max_x, float min_y, float max_y)
+{
+    int i = 0;
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    // Host: four particles per vector, the arrays are 16-byte aligned and padded to a multiple of four
+#if defined(__SSE2__)
+    __m128 lo_x = _mm_set1_ps(min_x), hi_x = _mm_set1_ps(max_x);
+    __m128 lo_y = _mm_set1_ps(min_y), hi_y = _mm_set1_ps(max_y);
+    __m128 step = _mm_set1_ps(dt);
+#else
+    float32x4_t lo_x = vdupq_n_f32(min_x), hi_x = vdupq_n_f32(max_x);
+    float32x4_t lo_y = vdupq_n_f32(min_y), hi_y = vdupq_n_f32(max_y);
+    float32x4_t step = vdupq_n_f32(dt);
+#endif
+    for(; i + 4 <= store->count; i += 4)
+    {
+        step_axis_x4(&store->x[i], &store->vx[i], &store->ax[i], lo_x, hi_x, step);
+        step_axis_x4(&store->y[i], &store->vy[i], &store->ay[i], lo_y, hi_y, step);
+    }
+#else
+    // Cortex-M4: the FPU has no floating point SIMD, so unroll by four like the CMSIS-DSP f32 block functions do and
+    // let the independent lanes fill the FPU pipeline
+    for(; i + 4 <= store->count; i += 4)
+    {
+        step_axis(store->x, store->vx, store->ax, i + 0, min_x, max_x, dt);
+        step_axis(store->x, store->vx, store->ax, i + 1, min_x, max_x, dt);
+        step_axis(store->x, store->vx, store->ax, i + 2, min_x, max_x, dt);
+        step_axis(store->x, store->vx, store->ax, i + 3, min_x, max_x, dt);
+        step_axis(store->y, store->vy, store->ay, i + 0, min_y, max_y, dt);
+        step_axis(store->y, store->vy, store->ay, i + 1, min_y, max_y, dt);
+        step_axis(store->y, store->vy, store->ay, i + 2, min_y, max_y, dt);
+        step_axis(store->y, store->vy, store->ay, i + 3, min_y, max_y, dt);
+    }
+#endif
+
+    for(; i < store->count; i++)
+    {
+        step_axis(store->x, store->vx, store->ax, i, min_x, max_x, dt);
+        step_axis(store->y, store->vy, store->ay, i, min_y, max_y, dt);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Separates two overlapping particles along the contact normal and exchanges the normal components of their
+// velocities, which is the elastic response for equal masses. Working with the normal directly needs one reciprocal
+// square root and no rotation into the contact frame, so no atan2/sin/cos.
+bool particles_collide(ParticleStore_t* store, int a, int b, float min_distance)
+{
+    float dx = store->x[a] - store->x[b];
+    float dy = store->y[a] - store->y[b];
+    float dist2 = dx * dx + dy * dy;
+
+    // Coincident centres have no normal to push along
+    if(dist2 >= min_distance * min_distance || dist2 == 0.0f)
+        return false;
+
+    float inv_dist = 1.0f / sqrtf(dist2);
+    float nx = dx * inv_dist;
+    float ny = dy * inv_dist;
+    float correction = (min_distance - dist2 * inv_dist) * 0.5f;
+
+    store->x[a] += nx * correction;
+    store->y[a] += ny * correction;
+    store->x[b] -= nx * correction;
+    store->y[b] -= ny * correction;
+    exchange_normal(store, a, b, nx, ny);
+
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The velocity half of particles_integrate(), for a caller that moves the particles itself
+void particles_damp(ParticleStore_t* store, float dt)
+{
+    for(int i = 0; i < store->count; i++)
+    {
+        store->vx[i] *= 1.0f - store->ax[i] * dt;
+        store->vy[i] *= 1.0f - store->ay[i] * dt;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Response of particles_collide() to two particles caught at the moment they touch. Only an approaching pair bounces,
+// whatever their distance, so that a contact found a hair too early or too late still ends with them moving apart. The
+// approach is tested on the centre offset before it is normalised, the same product a time of impact is solved with.
+bool particles_bounce(ParticleStore_t* store, int a, int b, float min_distance)
+{
+    float dx = store->x[a] - store->x[b];
+    float dy = store->y[a] - store->y[b];
+    float dist2 = dx * dx + dy * dy;
+
+    if(dist2 == 0.0f || (store->vx[b] - store->vx[a]) * dx + (store->vy[b] - store->vy[a]) * dy <= 0.0f)
+        return false;
+
+    float inv_dist = 1.0f / sqrtf(dist2);
+    float nx = dx * inv_dist;
+    float ny = dy * inv_dist;
+
+    if(dist2 < min_distance * min_distance)
+    {
+        float correction = (min_distance - dist2 * inv_dist) * 0.5f;
+
+        store->x[a] += nx * correction;
+        store->y[a] += ny * correction;
+        store->x[b] -= nx * correction;
+        store->y[b] -= ny * correction;
+    }
+    exchange_normal(store, a, b, nx, ny);
+
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,61 @@
+#ifndef __PARTICLES_H
+#define __PARTICLES_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Every array of the store is padded to a whole number of 4-float vectors, so if the backing block is 16-byte
+// aligned all of them are
+#define PARTICLES_CAPACITY(count)       (((count) + 3) & ~3)
+#define PARTICLES_FLOATS(count)         (6 * PARTICLES_CAPACITY(count))
+
+#if defined(__ICCARM__)
+#define PARTICLES_ALIGNED(decl)         _Pragma("data_alignment=16") decl
+#else
+#define PARTICLES_ALIGNED(decl)         decl __attribute__((aligned(16)))
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Structure-of-arrays particle storage: position, velocity (pixels per second) and per axis friction (fraction of the
+// velocity lost per second)
+typedef struct ParticleStore_s
+{
+    int count;
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* ax;
+    float* ay;
+    uint16_t* color;
+}ParticleStore_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+void particles_init(ParticleStore_t* store, float* data, uint16_t* color, int count);
+void particles_integrate(ParticleStore_t* store, float dt, float min_x, float max_x, float min_y, float max_y);
+bool particles_collide(ParticleStore_t* store, int a, int b, float min_distance);
+void particles_damp(ParticleStore_t* store, float dt);
+bool particles_bounce(ParticleStore_t* store, int a, int b, float min_distance);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PARTICLES_H */
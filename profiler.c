@@ -0,0 +1,119 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "profiler.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// The p99 of up to PROFILE_HISTORY frames is one of their few largest values, no more of them need to be kept
+#define PROFILE_TOP                     (PROFILE_HISTORY / 100 + 1)
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static const char* const phase_names[PROFILE_PHASES] =
+{
+    "integrate",
+    "tree",
+    "broad",
+    "narrow",
+    "erase",
+    "draw",
+    "sleep",
+};
+
+static uint32_t current[PROFILE_PHASES];
+static uint32_t history[PROFILE_PHASES][PROFILE_HISTORY];
+static uint32_t frames[PROFILE_PHASES];
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void profiler_init(void)
+{
+    cycle_counter_init();
+
+    for(int phase = 0; phase < PROFILE_PHASES; phase++)
+    {
+        current[phase] = 0;
+        frames[phase] = 0;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void profiler_add(ProfilePhase_t phase, uint32_t cycles)
+{
+    current[phase] += cycles;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t profiler_current(ProfilePhase_t phase)
+{
+    return current[phase];
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void profiler_end_frame(ProfilePhase_t first, ProfilePhase_t last)
+{
+    for(int phase = first; phase <= last; phase++)
+    {
+        history[phase][frames[phase] % PROFILE_HISTORY] = current[phase];
+        frames[phase]++;
+        current[phase] = 0;
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void profiler_stats(ProfilePhase_t phase, ProfileStats_t* stats)
+{
+    uint32_t count = (frames[phase] < PROFILE_HISTORY) ? frames[phase] : PROFILE_HISTORY;
+    // Nearest rank: the p99 is the k-th largest frame, k = count - ceil(0.99 * count) + 1
+    uint32_t rank = count - (99 * count + 99) / 100 + 1;
+    uint32_t top[PROFILE_TOP];
+    uint32_t kept = 0;
+    uint64_t sum = 0;
+
+    stats->frames = count;
+    stats->min = 0;
+    stats->avg = 0;
+    stats->max = 0;
+    stats->p99 = 0;
+    if(count == 0)
+        return;
+
+    stats->min = UINT32_MAX;
+    for(uint32_t i = 0; i < count; i++)
+    {
+        uint32_t sample = history[phase][i];
+        uint32_t slot;
+
+        sum += sample;
+        if(sample < stats->min)
+            stats->min = sample;
+
+        // top[] holds the largest samples so far in descending order, at most rank of them
+        if(kept == rank && sample <= top[kept - 1])
+            continue;
+        if(kept < rank)
+            kept++;
+        for(slot = kept - 1; slot > 0 && top[slot - 1] < sample; slot--)
+        {
+            top[slot] = top[slot - 1];
+        }
+        top[slot] = sample;
+    }
+
+    stats->avg = (uint32_t)(sum / count);
+    stats->max = top[0];
+    stats->p99 = top[rank - 1];
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+const char* profiler_phase_name(ProfilePhase_t phase)
+{
+    return phase_names[phase];
+}
+// ---------------------------------------------------------------------------------------------------------------------
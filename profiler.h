@@ -0,0 +1,90 @@
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "utils.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+// Frames each phase remembers, the statistics cover the last PROFILE_HISTORY of them
+#ifndef PROFILE_HISTORY
+#define PROFILE_HISTORY                 128
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Where a frame goes. The physics step owns the first four, the render frame the rest.
+typedef enum
+{
+    PROFILE_INTEGRATE,
+    PROFILE_TREE,               // keeping the broad phase structure up to date: rtree moves or reload, grid rebuild
+    PROFILE_BROAD_PHASE,        // finding the candidate pairs, includes resolving them early when the pair list fills up
+    PROFILE_NARROW_PHASE,
+    PROFILE_ERASE,              // working out what changed on screen since the buffer was last drawn
+    PROFILE_DRAW,
+    PROFILE_SLEEP,              // render task blocked on the display or the DMA2D
+    PROFILE_PHASES
+}ProfilePhase_t;
+
+// Counter units per frame, convert with cycle_counter_rate()
+typedef struct ProfileStats_s
+{
+    uint32_t min;
+    uint32_t avg;
+    uint32_t max;
+    uint32_t p99;
+    uint32_t frames;            // frames the figures cover, up to PROFILE_HISTORY
+}ProfileStats_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Time spent in each phase adds up over a frame, closing the frame moves the totals of its phases into their rings.
+// Each phase must only be added to and closed by one task, the statistics of another task's phases are only as fresh
+// as its last closed frame.
+void profiler_init(void);
+void profiler_add(ProfilePhase_t phase, uint32_t cycles);
+// Time added to the frame still open
+uint32_t profiler_current(ProfilePhase_t phase);
+// Closes the frame for the phases first to last
+void profiler_end_frame(ProfilePhase_t first, ProfilePhase_t last);
+void profiler_stats(ProfilePhase_t phase, ProfileStats_t* stats);
+const char* profiler_phase_name(ProfilePhase_t phase);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Class
+// ---------------------------------------------------------------------------------------------------------------------
+// Adds the time from its construction to the end of the enclosing block to a phase
+class ProfileScope
+{
+    public:
+        explicit ProfileScope(ProfilePhase_t phase) : phase(phase), start(cycle_counter_read()) {}
+
+        ~ProfileScope(void)
+        {
+            profiler_add(phase, cycle_counter_read() - start);
+        }
+
+    private:
+        ProfilePhase_t phase;
+        uint32_t start;
+};
+// ---------------------------------------------------------------------------------------------------------------------
+#endif
+
+#endif /* __PROFILER_H */
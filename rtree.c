@@ -20,8 +20,24 @@ extern "C"
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 
 #define ALLOW_REINSERTS
-#define MAXITEMS 32      // 32 max items per node
+#define MAXITEMS RTREE_MAXITEMS
 #define MINFILL  20      // 20% min fill
+#define MAXDIMS  8       // max dims when RTREE_DIMS is 0, sizes the stack rects
+
+// DIMS is a constant when RTREE_DIMS fixes the dimensions at compile time, so
+// rect sizes, copies, loops and the dims switches below all fold away.
+#if RTREE_DIMS
+#define DIMS(rtree) RTREE_DIMS
+#else
+#define DIMS(rtree) ((rtree)->dims)
+#endif
+
+// rtree_area_t holds areas and extents, which do not fit in an int16 coord.
+#ifdef RTREE_INT16
+typedef int32_t rtree_area_t;
+#else
+typedef rtree_coord_t rtree_area_t;
+#endif
 
 static void *(*_malloc)(size_t) = NULL;
 static void (*_free)(void *) = NULL;
@@ -64,6 +80,27 @@ struct pool {
     struct group branches;
 };
 
+// slab is one fixed size node kind of the arena. Nodes are carved from the
+// buffer in order the first time around, freed nodes are chained through
+// next and handed out again first.
+struct slab {
+    char *base;
+    size_t size;        // bytes per node
+    size_t cap;         // nodes in the slab
+    size_t carved;      // nodes handed out at least once
+    size_t used;        // nodes in use, including the ones held for splits
+    size_t peak;        // high-water mark of used
+    struct node *free;
+};
+
+struct arena {
+    struct slab leaves;
+    struct slab branches;
+};
+
+// The node header must fit in the room RTREE_ARENA_SIZE leaves for it.
+typedef char node_header_fits[sizeof(struct node) <= RTREE_NODE_HEADER ? 1 : -1];
+
 struct rtree {
     size_t elsize;
     int dims;
@@ -71,24 +108,56 @@ struct rtree {
     int min_items;
     int height;
     struct pool pool;
+    bool use_arena;
+    struct arena arena;
     size_t count;
     struct node *root;
-    double *rect;   
+    rtree_coord_t *rect;   
 
     bool use_reinsert;
     struct node *reinsert;
     size_t reinsert_count;
 };
 
+static struct node *slab_take(struct slab *slab) {
+    struct node *node;
+    if (slab->free) {
+        node = slab->free;
+        slab->free = node->next;
+    } else if (slab->carved < slab->cap) {
+        node = (struct node *)(void*)(slab->base + slab->size*slab->carved++);
+    } else {
+        return NULL;
+    }
+    slab->used++;
+    slab->peak = MAX(slab->peak, slab->used);
+    return node;
+}
+
+static void slab_give(struct slab *slab, struct node *node) {
+    node->next = slab->free;
+    slab->free = node;
+    slab->used--;
+}
+
+static size_t slab_avail(struct slab *slab) {
+    return slab->cap - slab->used;
+}
+
 // node_new returns a new internal rtree node. The allocation is oversized and
 // the rect and data (items and children) are allocated specifically for a
-// leaf or branch.
+// leaf or branch. With an arena the node is a slab of it instead.
 static struct node *node_new(struct rtree *rtree, bool leaf){
     size_t elsize = leaf?rtree->elsize:sizeof(struct node*);
-    size_t rectsz = 8 * rtree->dims * 2 * (rtree->max_items+1);
+    size_t rectsz = sizeof(rtree_coord_t) * DIMS(rtree) * 2 * (rtree->max_items+1);
     size_t datasz = elsize * (rtree->max_items+1);
     size_t nodesz = sizeof(struct node) + rectsz + datasz;
-    struct node *node = (struct node *)rtmalloc(nodesz);
+    struct node *node;
+    if (rtree->use_arena) {
+        node = slab_take(leaf ? &rtree->arena.leaves : &rtree->arena.branches);
+    } else {
+        node = (struct node *)rtmalloc(nodesz);
+    }
     if (!node) {
         return NULL;
     }
@@ -99,6 +168,16 @@ static struct node *node_new(struct rtree *rtree, bool leaf){
     return node;
 }
 
+// node_dispose frees a single node, back to the arena if there is one.
+static void node_dispose(struct rtree *rtree, struct node *node) {
+    if (rtree->use_arena) {
+        slab_give(node->leaf ? &rtree->arena.leaves : &rtree->arena.branches,
+                  node);
+    } else {
+        rtfree(node);
+    }
+}
+
 // item_at returns a leaf item at index
 static void *item_at(struct rtree *rtree, struct node *node, int index) {
     return ((char*)node->data) + rtree->elsize * index;
@@ -109,11 +188,11 @@ static void item_copy(struct rtree *rtree, void *item, void *from) {
 }
 
 // rect_at returns a node rect at index
-static double *rect_at(struct rtree *rtree, struct node *node, int index) {
-    return (double *)((void*)(((char*)node->rect) + (8 * rtree->dims * 2) * index));
+static rtree_coord_t *rect_at(struct rtree *rtree, struct node *node, int index) {
+    return (rtree_coord_t *)((void*)(((char*)node->rect) + (sizeof(rtree_coord_t) * DIMS(rtree) * 2) * index));
 }
-static void rect_copy(struct rtree *rtree, double *rect, double *from) {
-    memcpy(rect, from, 8*rtree->dims*2);
+static void rect_copy(struct rtree *rtree, rtree_coord_t *rect, rtree_coord_t *from) {
+    memcpy(rect, from, sizeof(rtree_coord_t)*DIMS(rtree)*2);
 }
 
 static struct node **node_at(struct rtree *rtree, struct node *node, 
@@ -149,7 +228,7 @@ static void node_rect_data_copy(struct rtree *rtree,
     }
 }
 
-static void rect_expand(double *rect, double *other, int dims) {
+static void rect_expand(rtree_coord_t *rect, rtree_coord_t *other, int dims) {
     rect[0] = MIN(rect[0], other[0]); 
     rect[dims+0] = MAX(rect[dims+0], other[dims+0]);
     for (int i = 1; i < dims; i++) {
@@ -159,15 +238,20 @@ static void rect_expand(double *rect, double *other, int dims) {
 }
 
 // rect_calc calculates a the node mbr and puts result into rect.
-static void rect_calc(struct rtree *rtree, struct node *node, double *rect) {
+static void rect_calc(struct rtree *rtree, struct node *node, rtree_coord_t *rect) {
     rect_copy(rtree, rect, rect_at(rtree, node, 0));
     for (int i = 1; i < node->count; i++) {
-        rect_expand(rect, rect_at(rtree, node, i), rtree->dims);
+        rect_expand(rect, rect_at(rtree, node, i), DIMS(rtree));
     }
 }
 
 struct rtree *rtree_new(size_t elsize, int dims) {
     if (dims < 1) panic("invalid dims");
+#if RTREE_DIMS
+    if (dims != RTREE_DIMS) panic("dims differs from RTREE_DIMS");
+#else
+    if (dims > MAXDIMS) panic("too many dims");
+#endif
     if (elsize == 0) panic("elsize is zero");
     struct rtree *rtree = (struct rtree *)rtmalloc(sizeof(struct rtree));
     if (!rtree) {
@@ -181,7 +265,7 @@ struct rtree *rtree_new(size_t elsize, int dims) {
     rtree->dims = dims;
     rtree->max_items = MAXITEMS;
     rtree->min_items = (rtree->max_items*MINFILL/100)+1;
-    rtree->rect = (double*)rtmalloc(8*dims*2);
+    rtree->rect = (rtree_coord_t*)rtmalloc(sizeof(rtree_coord_t)*DIMS(rtree)*2);
     if (!rtree->rect) {
         rtfree(rtree);
         return NULL;
@@ -194,11 +278,19 @@ static struct node *gimme_node(struct group *group) {
     return group->nodes[--group->len];
 }
 
+// With an arena, fill_pool has already made sure the slabs have room, so
+// nodes come straight from them and the groups stay empty.
 static struct node *gimme_leaf(struct rtree *rtree) {
+    if (rtree->use_arena) {
+        return node_new(rtree, true);
+    }
     return gimme_node(&rtree->pool.leaves);
 }
 
 static struct node *gimme_branch(struct rtree *rtree) {
+    if (rtree->use_arena) {
+        return node_new(rtree, false);
+    }
     return gimme_node(&rtree->pool.branches);
 }
 
@@ -218,6 +310,10 @@ static bool grow_group(struct group *group) {
 static void takeaway(struct rtree *rtree, struct node *node) {
     const int MAXLEN = 32;
     struct group *group;
+    if (rtree->use_arena) {
+        node_dispose(rtree, node);
+        return;
+    }
     if (node->leaf) {
         group = &rtree->pool.leaves;
     } else {
@@ -240,7 +336,12 @@ static void takeaway(struct rtree *rtree, struct node *node) {
 // is enough memory before we begin doing to things like splits and tree
 // rebalancing. There needs to be at least two available leaf and N branches
 // where N is equal to the height of the tree plus one.
+// An arena only has to have that many nodes left.
 static bool fill_pool(struct rtree *rtree) {
+    if (rtree->use_arena) {
+        return slab_avail(&rtree->arena.leaves) >= 2 &&
+               slab_avail(&rtree->arena.branches) >= (size_t)rtree->height+1;
+    }
     while (rtree->pool.leaves.len < 2) {
         if (rtree->pool.leaves.len == rtree->pool.leaves.cap) {
             if (!grow_group(&rtree->pool.leaves)) {
@@ -268,11 +369,11 @@ static bool fill_pool(struct rtree *rtree) {
     return true;
 }
 
-static int rect_largest_axis(double *rect, int dims) {
+static int rect_largest_axis(rtree_coord_t *rect, int dims) {
     int axis = 0;
-    double size = rect[dims+0]-rect[0];
+    rtree_area_t size = rect[dims+0]-rect[0];
     for (int i = 1; i < dims; i++) {
-        double nsize = rect[dims+i]-rect[i];
+        rtree_area_t nsize = rect[dims+i]-rect[i];
         if (nsize > size) {
             axis = i;
             size = nsize;
@@ -286,20 +387,20 @@ static int rect_largest_axis(double *rect, int dims) {
 // R-tree implemention. 
 // For more information please visit https://github.com/tidwall/rbang
 static struct node *node_split(struct rtree *rtree, struct node *node, 
-                               double *rect)
+                               rtree_coord_t *rect)
 {
-    int dims = rtree->dims;
+    int dims = DIMS(rtree);
     int axis = rect_largest_axis(rect, dims);
-    double axis_min = rect[axis];
-    double axis_max = rect[dims+axis];
+    rtree_coord_t axis_min = rect[axis];
+    rtree_coord_t axis_max = rect[dims+axis];
     struct node *right = node->leaf ? gimme_leaf(rtree) : gimme_branch(rtree);
     right->count = 0;
     struct node *equals = node->leaf ? gimme_leaf(rtree) : gimme_branch(rtree);
     equals->count = 0;
     for (int i = 0; i < node->count; i++) {
-        double *crect = rect_at(rtree, node, i); // child rect
-        double min_dist = crect[axis] - axis_min;
-        double max_dist = axis_max - crect[dims+axis];
+        rtree_coord_t *crect = rect_at(rtree, node, i); // child rect
+        rtree_area_t min_dist = crect[axis] - axis_min;
+        rtree_area_t max_dist = axis_max - crect[dims+axis];
         if (min_dist < max_dist) {
             // keep the child in the left node
             continue;
@@ -333,11 +434,11 @@ static struct node *node_split(struct rtree *rtree, struct node *node,
 
 // rect_enlarged_area calculates the enlarged area rect when unioned with other
 // rect, and it also calculates the total area of rect.
-static double rect_enlarged_area_d(double *rect, double *other, int dims, 
-                                   double *area_out)
+static rtree_area_t rect_enlarged_area_d(rtree_coord_t *rect, rtree_coord_t *other, int dims, 
+                                   rtree_area_t *area_out)
 {
-    double enlarged = MAX(other[dims+0], rect[dims+0]) - MIN(other[0], rect[0]);
-    double area = rect[dims+0] - rect[0];
+    rtree_area_t enlarged = MAX(other[dims+0], rect[dims+0]) - MIN(other[0], rect[0]);
+    rtree_area_t area = rect[dims+0] - rect[0];
     for (int i = 1; i < dims; i++) {
         enlarged *= MAX(other[dims+i], rect[dims+i]) - MIN(other[i], rect[i]);
         area *= rect[dims+i] - rect[i];
@@ -345,39 +446,39 @@ static double rect_enlarged_area_d(double *rect, double *other, int dims,
     *area_out = area;
     return enlarged - area;
 }
-static double rect_enlarged_area_2(double *rect, double *other, int dims, 
-                                   double *area_out)
+static rtree_area_t rect_enlarged_area_2(rtree_coord_t *rect, rtree_coord_t *other, int dims, 
+                                   rtree_area_t *area_out)
 {
-    double area = (rect[dims+0] - rect[0]) *
+    rtree_area_t area = (rect[dims+0] - rect[0]) *
                   (rect[dims+1] - rect[1]);
-    double enlarged = 
+    rtree_area_t enlarged = 
         (MAX(other[dims+0], rect[dims+0]) - MIN(other[0], rect[0])) *
         (MAX(other[dims+1], rect[dims+1]) - MIN(other[1], rect[1]));    
     *area_out = area;
     return enlarged - area;
 }
-static double rect_enlarged_area_3(double *rect, double *other, int dims, 
-                                   double *area_out)
+static rtree_area_t rect_enlarged_area_3(rtree_coord_t *rect, rtree_coord_t *other, int dims, 
+                                   rtree_area_t *area_out)
 {
-    double enlarged = 
+    rtree_area_t enlarged = 
         (MAX(other[dims+0], rect[dims+0]) - MIN(other[0], rect[0])) *
         (MAX(other[dims+1], rect[dims+1]) - MIN(other[1], rect[1])) *
         (MAX(other[dims+2], rect[dims+2]) - MIN(other[2], rect[2]));    
-    double area = (rect[dims+0] - rect[0]) *
+    rtree_area_t area = (rect[dims+0] - rect[0]) *
                   (rect[dims+1] - rect[1]) *
                   (rect[dims+2] - rect[2]);
     *area_out = area;
     return enlarged - area;
 }
-static double rect_enlarged_area_4(double *rect, double *other, int dims, 
-                                   double *area_out)
+static rtree_area_t rect_enlarged_area_4(rtree_coord_t *rect, rtree_coord_t *other, int dims, 
+                                   rtree_area_t *area_out)
 {
-    double enlarged = 
+    rtree_area_t enlarged = 
         (MAX(other[dims+0], rect[dims+0]) - MIN(other[0], rect[0])) *
         (MAX(other[dims+1], rect[dims+1]) - MIN(other[1], rect[1])) *
         (MAX(other[dims+2], rect[dims+2]) - MIN(other[2], rect[2])) *
         (MAX(other[dims+3], rect[dims+3]) - MIN(other[3], rect[3]));    
-    double area = (rect[dims+0] - rect[0]) *
+    rtree_area_t area = (rect[dims+0] - rect[0]) *
                   (rect[dims+1] - rect[1]) *
                   (rect[dims+2] - rect[2]) *
                   (rect[dims+3] - rect[3]);
@@ -390,15 +491,15 @@ static double rect_enlarged_area_4(double *rect, double *other, int dims,
 // candidate enlargments are equal, the one with the smallest area wins.
 #define FN_SUBTREE(fn_subtree, fn_rect_enlarged_area) \
 static int \
-fn_subtree(double *rects, int nrects, double *rect, int dims) { \
-    double *crect = rects; \
+fn_subtree(rtree_coord_t *rects, int nrects, rtree_coord_t *rect, int dims) { \
+    rtree_coord_t *crect = rects; \
     int j = 0; \
-    double j_area; \
-    double j_enlargement = fn_rect_enlarged_area(crect, rect, dims, &j_area); \
+    rtree_area_t j_area; \
+    rtree_area_t j_enlargement = fn_rect_enlarged_area(crect, rect, dims, &j_area); \
     for (int i = 1; i < nrects; i++) { \
         crect += dims*2; \
-        double area; \
-        double enlargement = fn_rect_enlarged_area(crect, rect, dims, &area); \
+        rtree_area_t area; \
+        rtree_area_t enlargement = fn_rect_enlarged_area(crect, rect, dims, &area); \
         if (enlargement > j_enlargement) { \
             continue; \
         } \
@@ -421,7 +522,7 @@ FN_SUBTREE(subtree_4, rect_enlarged_area_4);
 
 // node_insert inserts an item into the node. If the node is a branch, then
 // a child node (subtree) is chosen until a leaf node is found.
-static void node_insert(struct rtree *rtree, struct node *node, double *rect, 
+static void node_insert(struct rtree *rtree, struct node *node, rtree_coord_t *rect, 
                         void *item)
 {
     if (node->leaf) {
@@ -430,18 +531,18 @@ static void node_insert(struct rtree *rtree, struct node *node, double *rect,
         node->count++;
         return;
     }
-    int dims = rtree->dims;
+    int dims = DIMS(rtree);
     int index;
-    switch (rtree->dims) {
-    case 2:  index = subtree_2((double*)node->rect, node->count, rect, dims); break;
-    case 3:  index = subtree_3((double*)node->rect, node->count, rect, dims); break;
-    case 4:  index = subtree_4((double*)node->rect, node->count, rect, dims); break;
-    default: index = subtree_d((double*)node->rect, node->count, rect, dims);
+    switch (DIMS(rtree)) {
+    case 2:  index = subtree_2((rtree_coord_t*)node->rect, node->count, rect, dims); break;
+    case 3:  index = subtree_3((rtree_coord_t*)node->rect, node->count, rect, dims); break;
+    case 4:  index = subtree_4((rtree_coord_t*)node->rect, node->count, rect, dims); break;
+    default: index = subtree_d((rtree_coord_t*)node->rect, node->count, rect, dims);
     }
     struct node *child = *node_at(rtree, node, index);
-    double *child_rect = rect_at(rtree, node, index);
+    rtree_coord_t *child_rect = rect_at(rtree, node, index);
     node_insert(rtree, child, rect, item);
-    rect_expand(child_rect, rect, rtree->dims);
+    rect_expand(child_rect, rect, DIMS(rtree));
     if (child->count == rtree->max_items+1) {
         struct node *right = node_split(rtree, child, child_rect);
         rect_calc(rtree, child, child_rect);
@@ -451,7 +552,7 @@ static void node_insert(struct rtree *rtree, struct node *node, double *rect,
     }
 }
 
-static bool rtree_insert_x(struct rtree *rtree, double *rect, void *item) {
+static bool rtree_insert_x(struct rtree *rtree, rtree_coord_t *rect, void *item) {
     if (!fill_pool(rtree)) {
         return false;
     }
@@ -466,17 +567,14 @@ static bool rtree_insert_x(struct rtree *rtree, double *rect, void *item) {
         return true;
     }
     node_insert(rtree, rtree->root, rect, item);
-    rect_expand(rtree->rect, rect, rtree->dims);
+    rect_expand(rtree->rect, rect, DIMS(rtree));
     if (rtree->root->count == rtree->max_items+1) {
         // overflow. split root into two and calculate their rects
-#warning USER CHANGING
-        //double right_rect[8*rtree->dims*2]; // VLA
-        
-        if(rtree->dims != 2)
-        {
-            panic();
-        }
-        double right_rect[8*2*2]; // VLA
+#if RTREE_DIMS
+        rtree_coord_t right_rect[RTREE_DIMS*2];
+#else
+        rtree_coord_t right_rect[MAXDIMS*2];
+#endif
         struct node *right = node_split(rtree, rtree->root, rtree->rect);
         rect_calc(rtree, rtree->root, rtree->rect);
         rect_calc(rtree, right, right_rect);
@@ -511,7 +609,7 @@ static void attempt_reinsert(struct rtree *rtree) {
         struct node *node = rtree->reinsert;
         while (node->count > 0) {
             void *item = item_at(rtree, node, node->count-1);
-            double *rect = rect_at(rtree, node, node->count-1);
+            rtree_coord_t *rect = rect_at(rtree, node, node->count-1);
             if (!rtree_insert_x(rtree, rect, item)) {
                 return; // out of memory, that's ok
             }
@@ -525,12 +623,12 @@ static void attempt_reinsert(struct rtree *rtree) {
 
 // rtree_insert inserts an item into the rtree. This operation performs a copy
 // of the data that is pointed to in the second and third arguments. The R-tree
-// expects a rectangle, which is an array of doubles, that has the first N
+// expects a rectangle, which is an array of rtree_coord_t, that has the first N
 // values as the minimum corner of the rect, and the next N values as the
 // maximum corner of the rect, where N is the number of dimensions provided
-// to rtree_new().
+// to rtree_new() (which must be RTREE_DIMS unless that is 0).
 // Returns false if the system is out of memory.
-bool rtree_insert(struct rtree *rtree, double *rect, void *item) {
+bool rtree_insert(struct rtree *rtree, rtree_coord_t *rect, void *item) {
     if (rtree->reinsert) {
         attempt_reinsert(rtree);
     }
@@ -543,7 +641,7 @@ static void node_free(struct rtree *rtree, struct node *node) {
             node_free(rtree, *node_at(rtree, node, i));
         }
     }
-    rtfree(node);
+    node_dispose(rtree, node);
 }
 
 static void release_pool(struct rtree *rtree) {
@@ -568,19 +666,66 @@ void rtree_free(struct rtree *rtree) {
     }
     release_pool(rtree);
     while (rtree->reinsert) {
-        rtfree(rtree->reinsert);
-        rtree->reinsert = rtree->reinsert->next;
+        struct node *next = rtree->reinsert->next;
+        node_dispose(rtree, rtree->reinsert);
+        rtree->reinsert = next;
     }
     rtfree(rtree->rect);
     rtfree(rtree);
 }
 
+// rtree_set_arena makes the rtree take its nodes from buf instead of the
+// allocator, so that inserts, deletes and loads never allocate. The buffer is
+// cut into a slab of the given number of leaves and a slab of branches that
+// fills the rest, RTREE_ARENA_SIZE() gives the size for a node count. Each
+// node kind keeps a freelist, so taking and returning a node is O(1).
+// An insert that does not find room returns false as if the system was out
+// of memory, rtree_arena_peak() tells how close the rtree came to that.
+// The rtree must be empty and buf must outlive it.
+// Returns false if buf cannot hold the leaves and at least one branch.
+bool rtree_set_arena(struct rtree *rtree, void *buf, size_t size, 
+                     size_t leaves) 
+{
+    if (rtree->root || rtree->reinsert) {
+        return false;
+    }
+    int dims = DIMS(rtree);
+    size_t rectsz = sizeof(rtree_coord_t)*dims*2*(rtree->max_items+1);
+    size_t leafsz = (RTREE_NODE_HEADER + rectsz + 
+                     rtree->elsize*(rtree->max_items+1) + 7) & ~(size_t)7;
+    size_t branchsz = (RTREE_NODE_HEADER + rectsz + 
+                       sizeof(struct node*)*(rtree->max_items+1) + 7) & ~(size_t)7;
+    size_t pad = (8 - (uintptr_t)buf%8) % 8;
+    if (size < pad || (size-pad)/leafsz < leaves || 
+        (size-pad-leaves*leafsz)/branchsz < 1) 
+    {
+        return false;
+    }
+    release_pool(rtree);
+    memset(&rtree->arena, 0, sizeof(struct arena));
+    rtree->arena.leaves.base = (char*)buf + pad;
+    rtree->arena.leaves.size = leafsz;
+    rtree->arena.leaves.cap = leaves;
+    rtree->arena.branches.base = (char*)buf + pad + leaves*leafsz;
+    rtree->arena.branches.size = branchsz;
+    rtree->arena.branches.cap = (size-pad-leaves*leafsz)/branchsz;
+    rtree->use_arena = true;
+    return true;
+}
+
+// rtree_arena_peak returns the most leaves and branches the rtree ever had
+// taken from its arena at once, or zeros without an arena.
+void rtree_arena_peak(struct rtree *rtree, size_t *leaves, size_t *branches) {
+    *leaves = rtree->arena.leaves.peak;
+    *branches = rtree->arena.branches.peak;
+}
+
 // rtree_count returns the number of items in the rtree.
 size_t rtree_count(struct rtree *rtree) {
     return rtree->count + rtree->reinsert_count;
 }
 
-static bool inter_d(double *rect, double *other, int dims) {
+static bool inter_d(rtree_coord_t *rect, rtree_coord_t *other, int dims) {
     if (rect[dims+0] < other[0] || rect[0] > other[dims+0]) {
         return false;
     }
@@ -591,16 +736,16 @@ static bool inter_d(double *rect, double *other, int dims) {
     }
     return true;
 }
-static bool inter_2(double *rect, double *other, int dims) {
+static bool inter_2(rtree_coord_t *rect, rtree_coord_t *other, int dims) {
     return !(rect[dims+0] < other[0] || rect[0] > other[dims+0] ||
              rect[dims+1] < other[1] || rect[1] > other[dims+1]);
 }
-static bool inter_3(double *rect, double *other, int dims) {
+static bool inter_3(rtree_coord_t *rect, rtree_coord_t *other, int dims) {
     return !(rect[dims+0] < other[0] || rect[0] > other[dims+0] ||
              rect[dims+1] < other[1] || rect[1] > other[dims+1] ||
              rect[dims+2] < other[2] || rect[2] > other[dims+2]);
 }
-static bool inter_4(double *rect, double *other, int dims) {
+static bool inter_4(rtree_coord_t *rect, rtree_coord_t *other, int dims) {
     return !(rect[dims+0] < other[0] || rect[0] > other[dims+0] ||
              rect[dims+1] < other[1] || rect[1] > other[dims+1] ||
              rect[dims+2] < other[2] || rect[2] > other[dims+2] ||
@@ -612,12 +757,12 @@ static bool inter_4(double *rect, double *other, int dims) {
 // for a specific dimensions.
 #define FN_SEARCH(fn_search, fn_inter) \
 static bool \
-fn_search(struct rtree *rtree, struct node *node, double *rect, \
-       bool (*iter)(const double *rect, const void *item, void *udata), \
+fn_search(struct rtree *rtree, struct node *node, rtree_coord_t *rect, \
+       bool (*iter)(const rtree_coord_t *rect, const void *item, void *udata), \
        void *udata) \
 { \
-    int dims = rtree->dims; \
-    double *crect = (double *)node->rect; \
+    int dims = DIMS(rtree); \
+    rtree_coord_t *crect = (rtree_coord_t *)node->rect; \
     if (node->leaf) { \
         for (int i = 0; i < node->count; i++) { \
             if (fn_inter(rect, crect, dims)) { \
@@ -648,16 +793,16 @@ FN_SEARCH(search_3, inter_3);
 FN_SEARCH(search_4, inter_4);
 
 // search_reinsert searches the reinsert list.
-static bool search_reinsert(struct rtree *rtree, double *rect, 
-                            bool (*iter)(const double *rect, const void *item, 
+static bool search_reinsert(struct rtree *rtree, rtree_coord_t *rect, 
+                            bool (*iter)(const rtree_coord_t *rect, const void *item, 
                                          void *udata), 
                             void *udata)
 {
     struct node *node = rtree->reinsert;
     while (node) {
         for (int i = 0; i < node->count; i++) {
-            double *crect = rect_at(rtree, node, i);
-            if (inter_d(rect, crect, rtree->dims)) {
+            rtree_coord_t *crect = rect_at(rtree, node, i);
+            if (inter_d(rect, crect, DIMS(rtree))) {
                 void *citem = item_at(rtree, node, i);
                 if (!iter(crect, citem, udata)) {
                     return false;
@@ -684,8 +829,8 @@ static void push_reinsert(struct rtree *rtree, struct node *node) {
     }
 }
 
-bool rtree_search(struct rtree *rtree, double *rect, 
-                  bool (*iter)(const double *rect, const void *item, 
+bool rtree_search(struct rtree *rtree, rtree_coord_t *rect, 
+                  bool (*iter)(const rtree_coord_t *rect, const void *item, 
                                void *udata), 
                   void *udata)
 {
@@ -695,7 +840,7 @@ bool rtree_search(struct rtree *rtree, double *rect,
         }
     }
     if (rtree->root) {
-        switch (rtree->dims) {
+        switch (DIMS(rtree)) {
         case 2:  return search_2(rtree, rtree->root, rect, iter, udata);
         case 3:  return search_3(rtree, rtree->root, rect, iter, udata);
         case 4:  return search_4(rtree, rtree->root, rect, iter, udata);
@@ -705,13 +850,163 @@ bool rtree_search(struct rtree *rtree, double *rect,
     return true;
 }
 
+// join is the state of one rtree_self_join walk.
+struct join {
+    struct rtree *rtree;
+    rtree_area_t pad;
+    bool (*iter)(const rtree_coord_t *rect, const void *item,
+                 const rtree_coord_t *other_rect, const void *other_item,
+                 void *udata);
+    void *udata;
+};
+
+// join_inter tells if two rects are within pad of each other.
+static bool join_inter(struct join *join, rtree_coord_t *rect, 
+                       rtree_coord_t *other) 
+{
+    int dims = DIMS(join->rtree);
+    for (int i = 0; i < dims; i++) {
+        if ((rtree_area_t)rect[dims+i] + join->pad < other[i] || 
+            (rtree_area_t)other[dims+i] + join->pad < rect[i]) 
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// join_cross reports the pairs between two distinct nodes of the same level.
+static bool join_cross(struct join *join, struct node *node, 
+                       struct node *other) 
+{
+    struct rtree *rtree = join->rtree;
+    for (int i = 0; i < node->count; i++) {
+        rtree_coord_t *rect = rect_at(rtree, node, i);
+        for (int j = 0; j < other->count; j++) {
+            rtree_coord_t *orect = rect_at(rtree, other, j);
+            if (!join_inter(join, rect, orect)) {
+                continue;
+            }
+            if (node->leaf) {
+                if (!join->iter(rect, item_at(rtree, node, i), 
+                                orect, item_at(rtree, other, j), 
+                                join->udata))
+                {
+                    return false;
+                }
+            } else if (!join_cross(join, *node_at(rtree, node, i), 
+                                   *node_at(rtree, other, j))) 
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// join_node reports the pairs inside a subtree: the ones under each child,
+// then the ones between every two children that are close enough.
+static bool join_node(struct join *join, struct node *node) {
+    struct rtree *rtree = join->rtree;
+    for (int i = 0; i < node->count; i++) {
+        rtree_coord_t *rect = rect_at(rtree, node, i);
+        if (!node->leaf && !join_node(join, *node_at(rtree, node, i))) {
+            return false;
+        }
+        for (int j = i+1; j < node->count; j++) {
+            rtree_coord_t *orect = rect_at(rtree, node, j);
+            if (!join_inter(join, rect, orect)) {
+                continue;
+            }
+            if (node->leaf) {
+                if (!join->iter(rect, item_at(rtree, node, i), 
+                                orect, item_at(rtree, node, j), 
+                                join->udata))
+                {
+                    return false;
+                }
+            } else if (!join_cross(join, *node_at(rtree, node, i), 
+                                   *node_at(rtree, node, j))) 
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// join_item reports the pairs between one item and a subtree.
+static bool join_item(struct join *join, struct node *node, 
+                      rtree_coord_t *rect, void *item) 
+{
+    struct rtree *rtree = join->rtree;
+    for (int i = 0; i < node->count; i++) {
+        rtree_coord_t *crect = rect_at(rtree, node, i);
+        if (!join_inter(join, rect, crect)) {
+            continue;
+        }
+        if (node->leaf) {
+            if (!join->iter(rect, item, crect, item_at(rtree, node, i), 
+                            join->udata)) 
+            {
+                return false;
+            }
+        } else if (!join_item(join, *node_at(rtree, node, i), rect, item)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// rtree_self_join walks the rtree against itself and calls iter once for
+// every unordered pair of distinct items whose rects are no more than pad
+// apart, which is every pair that overlaps for a pad of zero. Which item of
+// a pair comes first is unspecified. This is a single walk instead of one
+// rtree_search per item, which would find each pair twice.
+// The rtree must not be modified from iter. Returning false from iter stops
+// the walk.
+// Returns false if the walk was stopped.
+bool rtree_self_join(struct rtree *rtree, rtree_coord_t pad,
+                     bool (*iter)(const rtree_coord_t *rect, 
+                                  const void *item,
+                                  const rtree_coord_t *other_rect, 
+                                  const void *other_item,
+                                  void *udata),
+                     void *udata)
+{
+    struct join join = { rtree, pad, iter, udata };
+    if (rtree->root && !join_node(&join, rtree->root)) {
+        return false;
+    }
+    // items waiting in the reinsert list pair with the tree and with the
+    // reinsert items after them
+    for (struct node *node = rtree->reinsert; node; node = node->next) {
+        if (!join_node(&join, node)) {
+            return false;
+        }
+        for (int i = 0; i < node->count; i++) {
+            rtree_coord_t *rect = rect_at(rtree, node, i);
+            void *item = item_at(rtree, node, i);
+            if (rtree->root && !join_item(&join, rtree->root, rect, item)) {
+                return false;
+            }
+            for (struct node *other = node->next; other; other = other->next) {
+                if (!join_item(&join, other, rect, item)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
 #define FN_NODE_DELETE(fn_node_delete, fn_inter) \
 static bool \
-fn_node_delete(struct rtree *rtree, struct node *node, double *rect, \
+fn_node_delete(struct rtree *rtree, struct node *node, rtree_coord_t *rect, \
                void *item) \
 {\
-    int dims = rtree->dims;\
-    double *crect = (double *)node->rect;\
+    int dims = DIMS(rtree);\
+    rtree_coord_t *crect = (rtree_coord_t *)node->rect;\
     if (node->leaf) {\
         for (int i = 0; i < node->count; i++) {\
             if (fn_inter(rect, crect, dims)) {\
@@ -765,14 +1060,14 @@ FN_NODE_DELETE(node_delete_4, inter_4);
 
 // delete_from_reinsert searches the reinsert list for the target item.
 // Returns true if the item was found and deleted.
-static bool delete_from_reinsert(struct rtree *rtree, double *rect, 
+static bool delete_from_reinsert(struct rtree *rtree, rtree_coord_t *rect, 
                                  void *item) 
 {
     struct node *node = rtree->reinsert;
     while (node) {
         for (int i = 0; i < node->count; i++) {
-            double *crect = rect_at(rtree, node, i);
-            if (inter_d(rect, crect, rtree->dims)) { 
+            rtree_coord_t *crect = rect_at(rtree, node, i);
+            if (inter_d(rect, crect, DIMS(rtree))) { 
                 void *citem = item_at(rtree, node, i);
                 if (memcmp(item, citem, rtree->elsize) == 0) {
                     node_rect_data_copy(rtree, node, i, node, node->count-1);
@@ -787,23 +1082,17 @@ static bool delete_from_reinsert(struct rtree *rtree, double *rect,
     return false;
 }
 
-// rtree_delete deletes an item from the rtree. 
-// Returns true if the item was deleted or false if the item was not found.
-bool rtree_delete(struct rtree *rtree, double *rect, void *item) {
-    // search the reinsert list
-    if (rtree->reinsert) {
-        bool deleted = delete_from_reinsert(rtree, rect, item);
-        attempt_reinsert(rtree);
-        if (deleted) {
-            return true;
-        }
-    }
-    // search the tree
+// rtree_delete_x deletes an item from the tree itself, leaving the reinsert
+// list alone. It never takes a node, the leaves it empties go to the reinsert
+// list and the nodes it drops go back to the pool.
+static bool rtree_delete_x(struct rtree *rtree, rtree_coord_t *rect, 
+                           void *item)
+{
     if (!rtree->root) {
         return false;
     }
     bool deleted;
-    switch (rtree->dims) {
+    switch (DIMS(rtree)) {
     case 2:  deleted = node_delete_2(rtree, rtree->root, rect, item); break;
     case 3:  deleted = node_delete_3(rtree, rtree->root, rect, item); break;
     case 4:  deleted = node_delete_4(rtree, rtree->root, rect, item); break;
@@ -828,6 +1117,24 @@ bool rtree_delete(struct rtree *rtree, double *rect, void *item) {
         }
         rect_calc(rtree, rtree->root, rtree->rect);
     }
+    return true;
+}
+
+// rtree_delete deletes an item from the rtree. 
+// Returns true if the item was deleted or false if the item was not found.
+bool rtree_delete(struct rtree *rtree, rtree_coord_t *rect, void *item) {
+    // search the reinsert list
+    if (rtree->reinsert) {
+        bool deleted = delete_from_reinsert(rtree, rect, item);
+        attempt_reinsert(rtree);
+        if (deleted) {
+            return true;
+        }
+    }
+    // search the tree
+    if (!rtree_delete_x(rtree, rect, item)) {
+        return false;
+    }
     // attempt to reinsert items from deleted leaves. 
     if (rtree->reinsert) {
         attempt_reinsert(rtree);
@@ -835,6 +1142,320 @@ bool rtree_delete(struct rtree *rtree, double *rect, void *item) {
     return true;
 }
 
+static bool rect_contains(rtree_coord_t *rect, rtree_coord_t *other, int dims) {
+    for (int i = 0; i < dims; i++) {
+        if (other[i] < rect[i] || other[dims+i] > rect[dims+i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+enum update_result { UPDATE_NOT_FOUND, UPDATE_DONE, UPDATE_NO_FIT };
+
+// node_update looks for the item under rect and moves it to new_rect if that
+// still fits node_rect, the rect of its leaf as stored in the parent (NULL
+// for a root leaf). On the way back up every ancestor rect is refit, as the
+// leaf may have shrunk.
+static enum update_result node_update(struct rtree *rtree, struct node *node,
+                                      rtree_coord_t *node_rect,
+                                      rtree_coord_t *rect, 
+                                      rtree_coord_t *new_rect, void *item)
+{
+    int dims = DIMS(rtree);
+    rtree_coord_t *crect = (rtree_coord_t *)node->rect;
+    if (node->leaf) {
+        for (int i = 0; i < node->count; i++) {
+            if (inter_d(rect, crect, dims) && 
+                memcmp(item_at(rtree, node, i), item, rtree->elsize) == 0) 
+            {
+                if (node_rect && !rect_contains(node_rect, new_rect, dims)) {
+                    return UPDATE_NO_FIT;
+                }
+                rect_copy(rtree, crect, new_rect);
+                return UPDATE_DONE;
+            }
+            crect += dims*2;
+        }
+    } else {
+        for (int i = 0; i < node->count; i++) {
+            if (inter_d(rect, crect, dims)) {
+                struct node *cnode = *node_at(rtree, node, i);
+                enum update_result result = 
+                    node_update(rtree, cnode, crect, rect, new_rect, item);
+                if (result == UPDATE_DONE) {
+                    rect_calc(rtree, cnode, crect);
+                }
+                if (result != UPDATE_NOT_FOUND) {
+                    return result;
+                }
+            }
+            crect += dims*2;
+        }
+    }
+    return UPDATE_NOT_FOUND;
+}
+
+// update_reinsert moves an item that is waiting in the reinsert list. Those
+// leaves have no parent rect to respect.
+static bool update_reinsert(struct rtree *rtree, rtree_coord_t *rect, 
+                            rtree_coord_t *new_rect, void *item)
+{
+    struct node *node = rtree->reinsert;
+    while (node) {
+        for (int i = 0; i < node->count; i++) {
+            rtree_coord_t *crect = rect_at(rtree, node, i);
+            if (inter_d(rect, crect, DIMS(rtree)) && 
+                memcmp(item_at(rtree, node, i), item, rtree->elsize) == 0) 
+            {
+                rect_copy(rtree, crect, new_rect);
+                return true;
+            }
+        }
+        node = node->next;
+    }
+    return false;
+}
+
+// rtree_update moves an item from rect to new_rect. When the new rect still
+// fits the rect its leaf has in the parent the entry is rewritten in place
+// and only the ancestors are refit, so small moves touch no node structure.
+// Otherwise the item is deleted and inserted again, once the pool is known to
+// hold the nodes the insert may need, and only then are the leaves the delete
+// emptied reinserted. An item is therefore never lost for want of nodes.
+// Returns false if the item was not found, or if there were no nodes for the
+// fallback, in which case the item stays under rect.
+bool rtree_update(struct rtree *rtree, rtree_coord_t *rect, 
+                  rtree_coord_t *new_rect, void *item) 
+{
+    if (rtree->reinsert && update_reinsert(rtree, rect, new_rect, item)) {
+        return true;
+    }
+    if (!rtree->root) {
+        return false;
+    }
+    switch (node_update(rtree, rtree->root, NULL, rect, new_rect, item)) {
+    case UPDATE_DONE:
+        rect_calc(rtree, rtree->root, rtree->rect);
+        return true;
+    case UPDATE_NO_FIT:
+        if (!fill_pool(rtree) || !rtree_delete_x(rtree, rect, item)) {
+            return false;
+        }
+        if (!rtree_insert_x(rtree, new_rect, item)) {
+            panic("no node for a reinsert");
+        }
+        if (rtree->reinsert) {
+            attempt_reinsert(rtree);
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+// node_release hands a subtree back to the node pool.
+static void node_release(struct rtree *rtree, struct node *node) {
+    if (!node->leaf) {
+        for (int i = 0; i < node->count; i++) {
+            node_release(rtree, *node_at(rtree, node, i));
+        }
+    }
+    takeaway(rtree, node);
+}
+
+// node_take returns a pooled node if there is one, otherwise a new one.
+static struct node *node_take(struct rtree *rtree, bool leaf) {
+    struct group *group = leaf ? &rtree->pool.leaves : &rtree->pool.branches;
+    if (group->len > 0) {
+        return group->nodes[--group->len];
+    }
+    return node_new(rtree, leaf);
+}
+
+// free_chain frees a list of nodes linked through next, with their subtrees.
+static void free_chain(struct rtree *rtree, struct node *node) {
+    while (node) {
+        struct node *next = node->next;
+        node_free(rtree, node);
+        node = next;
+    }
+}
+
+// entry_key is the center of an entry along axis, times two.
+static rtree_area_t entry_key(rtree_coord_t *rects, int dims, size_t index, 
+                              int axis) 
+{
+    rtree_coord_t *rect = rects + dims*2*index;
+    return (rtree_area_t)rect[axis] + (rtree_area_t)rect[dims+axis];
+}
+
+static void entry_swap(struct rtree *rtree, rtree_coord_t *rects, char *items,
+                       size_t i, size_t j)
+{
+    int dims = DIMS(rtree);
+    rtree_coord_t rtmp[MAXDIMS*2];
+    memcpy(rtmp, rects+dims*2*i, sizeof(rtree_coord_t)*dims*2);
+    memcpy(rects+dims*2*i, rects+dims*2*j, sizeof(rtree_coord_t)*dims*2);
+    memcpy(rects+dims*2*j, rtmp, sizeof(rtree_coord_t)*dims*2);
+    char itmp[16];
+    for (size_t k = 0; k < rtree->elsize; k += sizeof(itmp)) {
+        size_t len = MIN(sizeof(itmp), rtree->elsize-k);
+        memcpy(itmp, items+rtree->elsize*i+k, len);
+        memcpy(items+rtree->elsize*i+k, items+rtree->elsize*j+k, len);
+        memcpy(items+rtree->elsize*j+k, itmp, len);
+    }
+}
+
+// sort_entries sorts the entries [lo, hi) by their center along axis. The
+// rects and items are parallel arrays, so this is a quicksort that swaps both,
+// finishing short ranges with an insertion sort.
+static void sort_entries(struct rtree *rtree, rtree_coord_t *rects, 
+                         char *items, size_t lo, size_t hi, int axis)
+{
+    int dims = DIMS(rtree);
+    while (hi - lo > 12) {
+        // the lower middle, so that the split below never leaves one side empty
+        rtree_area_t pivot = entry_key(rects, dims, lo+(hi-lo-1)/2, axis);
+        size_t i = lo, j = hi-1;
+        for (;;) {
+            while (entry_key(rects, dims, i, axis) < pivot) i++;
+            while (entry_key(rects, dims, j, axis) > pivot) j--;
+            if (i >= j) {
+                break;
+            }
+            entry_swap(rtree, rects, items, i, j);
+            i++;
+            j--;
+        }
+        // [lo, j] <= pivot <= [j+1, hi), recurse into the smaller half
+        if (j+1-lo < hi-(j+1)) {
+            sort_entries(rtree, rects, items, lo, j+1, axis);
+            lo = j+1;
+        } else {
+            sort_entries(rtree, rects, items, j+1, hi, axis);
+            hi = j+1;
+        }
+    }
+    for (size_t i = lo+1; i < hi; i++) {
+        for (size_t j = i; j > lo && entry_key(rects, dims, j-1, axis) > 
+                                     entry_key(rects, dims, j, axis); j--) 
+        {
+            entry_swap(rtree, rects, items, j-1, j);
+        }
+    }
+}
+
+// rtree_bulk_load replaces the contents of the rtree with n items, packed
+// with Sort-Tile-Recursive: the entries are sorted along the first axis,
+// cut into sqrt(leaves) slices, each slice is sorted along the second axis
+// and cut into leaves. Upper levels group consecutive nodes. Every node ends
+// up as full as an even split allows, which is cheaper to build and search
+// than n rtree_insert calls.
+// The rects and items are parallel arrays laid out like rtree_insert expects
+// them, and both are reordered in place. No memory is allocated beyond the
+// nodes themselves, which are taken from the pool first.
+// Returns false if the system is out of memory, leaving the rtree empty.
+bool rtree_bulk_load(struct rtree *rtree, rtree_coord_t *rects, void *items,
+                     size_t n)
+{
+    int dims = DIMS(rtree);
+    size_t max_items = (size_t)rtree->max_items;
+
+    // drop the current contents
+    if (rtree->root) {
+        node_release(rtree, rtree->root);
+        rtree->root = NULL;
+    }
+    while (rtree->reinsert) {
+        struct node *next = rtree->reinsert->next;
+        takeaway(rtree, rtree->reinsert);
+        rtree->reinsert = next;
+    }
+    rtree->reinsert_count = 0;
+    rtree->count = 0;
+    rtree->height = 0;
+    if (n == 0) {
+        return true;
+    }
+
+    // sort and tile
+    size_t nleaves = (n+max_items-1)/max_items;
+    sort_entries(rtree, rects, (char*)items, 0, n, 0);
+    if (dims > 1) {
+        size_t nslices = 1;
+        while (nslices*nslices < nleaves) {
+            nslices++;
+        }
+        for (size_t i = 0; i < nslices; i++) {
+            size_t lo = n*(nleaves*i/nslices)/nleaves;
+            size_t hi = n*(nleaves*(i+1)/nslices)/nleaves;
+            sort_entries(rtree, rects, (char*)items, lo, hi, 1);
+        }
+    }
+
+    // leaves, chained through next
+    struct node *chain = NULL;
+    struct node **tail = &chain;
+    for (size_t i = 0; i < nleaves; i++) {
+        struct node *leaf = node_take(rtree, true);
+        if (!leaf) {
+            free_chain(rtree, chain);
+            return false;
+        }
+        leaf->count = 0;
+        leaf->next = NULL;
+        for (size_t j = n*i/nleaves; j < n*(i+1)/nleaves; j++) {
+            rect_copy(rtree, rect_at(rtree, leaf, leaf->count), 
+                      rects + dims*2*j);
+            item_copy(rtree, item_at(rtree, leaf, leaf->count), 
+                      (char*)items + rtree->elsize*j);
+            leaf->count++;
+        }
+        *tail = leaf;
+        tail = &leaf->next;
+    }
+
+    // branches, one level at a time until a single root is left
+    int height = 1;
+    size_t count = nleaves;
+    while (count > 1) {
+        size_t nparents = (count+max_items-1)/max_items;
+        struct node *parents = NULL;
+        struct node **ptail = &parents;
+        struct node *child = chain;
+        for (size_t i = 0; i < nparents; i++) {
+            struct node *parent = node_take(rtree, false);
+            if (!parent) {
+                free_chain(rtree, parents);
+                free_chain(rtree, child);
+                return false;
+            }
+            parent->count = 0;
+            parent->next = NULL;
+            for (size_t j = count*i/nparents; j < count*(i+1)/nparents; j++) {
+                struct node *next = child->next;
+                rect_calc(rtree, child, rect_at(rtree, parent, parent->count));
+                node_copy(rtree, node_at(rtree, parent, parent->count), 
+                          &child);
+                parent->count++;
+                child = next;
+            }
+            *ptail = parent;
+            ptail = &parent->next;
+        }
+        chain = parents;
+        count = nparents;
+        height++;
+    }
+
+    rtree->root = chain;
+    rtree->height = height;
+    rtree->count = n;
+    rect_calc(rtree, rtree->root, rtree->rect);
+    return true;
+}
+
 //==============================================================================
 // TESTS AND BENCHMARKS
 // $ cc -DRTREE_TEST rtree.c && ./a.out              # run tests
@@ -848,17 +1469,18 @@ bool rtree_delete(struct rtree *rtree, double *rect, void *item) {
 #include "cities.xh"
 #endif
 #include <assert.h>
+#include <stdint.h>
 #include <time.h>
 
 static const double svg_scale = 20.0;
 static const char *strokes[] = { "black", "red", "green", "purple" };
 static const int nstrokes = 4;
 
-static void node_write_svg(struct rtree *rtree, struct node *node, double *rect,
+static void node_write_svg(struct rtree *rtree, struct node *node, rtree_coord_t *rect,
                            FILE *f, int height, int depth) 
 {
-    double *min = rect;
-    double *max = &rect[rtree->dims];
+    rtree_coord_t *min = rect;
+    rtree_coord_t *max = &rect[rtree->dims];
     bool point = min[0] == max[0] && min[1] == max[1];
     if (node) {
         if (!node->leaf) {
@@ -919,13 +1541,13 @@ void rtree_write_svg(struct rtree *rtree, const char *path) {
 
 
 static void node_deep_check(struct rtree *rtree, struct node *node, 
-                            double *rect, int height, int depth)
+                            rtree_coord_t *rect, int height, int depth)
 {
     assert(node->count);
     assert(height);
-    double rect2[8*rtree->dims*2]; // VLA
+    rtree_coord_t rect2[rtree->dims*2]; // VLA
     for (int i = 0; i < node->count; i++) {
-        double *child_rect = rect_at(rtree, node, i);
+        rtree_coord_t *child_rect = rect_at(rtree, node, i);
         assert((node->leaf && height == 1) || (!node->leaf && height > 1));
         // for (int j = 0; j < depth; j++) { printf("  "); }
         // printf("%d: ", i); print_rect(rtree, child_rect); printf("\n");
@@ -939,7 +1561,7 @@ static void node_deep_check(struct rtree *rtree, struct node *node,
             rect_expand(rect2, child_rect, rtree->dims);
         }
     }
-    assert(memcmp(rect, rect2, 8*rtree->dims*2) == 0);
+    assert(memcmp(rect, rect2, sizeof(rtree_coord_t)*rtree->dims*2) == 0);
 }
 
 static void rtree_deep_check(struct rtree *rtree) {
@@ -954,20 +1576,20 @@ static void rtree_deep_check(struct rtree *rtree) {
 }
 
 
-void print_rect(struct rtree *rtree, double *rect) {
+void print_rect(struct rtree *rtree, rtree_coord_t *rect) {
     printf("[[");
     for (int i = 0; i < rtree->dims; i++) {
         if (i > 0) {
             printf(",");
         }
-        printf("%f",rect[i]);
+        printf("%f",(double)rect[i]);
     }
     printf("],[");
     for (int i = 0; i < rtree->dims; i++) {
         if (i > 0) {
             printf(",");
         }
-        printf("%f",rect[rtree->dims+i]);
+        printf("%f",(double)rect[rtree->dims+i]);
     }
     printf("]]");
 }
@@ -1008,7 +1630,7 @@ static void shuffle(void *array, int numels, int elsize) {
     }
 }
 
-static void copy_rand_point(int dims, double *point) {
+static void copy_rand_point(int dims, rtree_coord_t *point) {
     for (int i = 0; i < dims; i++) {
         if (i == 0) {
             point[i] = ((double)rand()/(double)RAND_MAX) * 360.0 - 180.0;
@@ -1021,22 +1643,22 @@ static void copy_rand_point(int dims, double *point) {
     }
 }
 
-static bool search_iter(const double *rect, const void *item, void *udata) {
+static bool search_iter(const rtree_coord_t *rect, const void *item, void *udata) {
     (*(int*)udata)++;
     return true;
 }
 
 struct single_ctx {
     int dims;
-    double *rect;
+    rtree_coord_t *rect;
     int index;
     bool found;
     struct rtree *rtree;
 };
 
-static bool single_iter(const double *rect, const void *item, void *udata) {
+static bool single_iter(const rtree_coord_t *rect, const void *item, void *udata) {
     struct single_ctx *ctx = udata;
-    if (memcmp(rect, ctx->rect, 8*ctx->dims*2) == 0 && 
+    if (memcmp(rect, ctx->rect, sizeof(rtree_coord_t)*ctx->dims*2) == 0 && 
         *(int*)item == ctx->index) 
     {
         ctx->found = true;
@@ -1045,7 +1667,7 @@ static bool single_iter(const double *rect, const void *item, void *udata) {
 }
 
 
-static bool tsearch(struct rtree *rtree, int dims, double *rect, int index) {
+static bool tsearch(struct rtree *rtree, int dims, rtree_coord_t *rect, int index) {
     struct single_ctx ctx = {
         .dims = dims,
         .rect = rect,
@@ -1056,18 +1678,61 @@ static bool tsearch(struct rtree *rtree, int dims, double *rect, int index) {
     return ctx.found;
 }
 
+struct join_ctx {
+    int N;
+    char *seen;
+};
+
+static bool join_iter(const rtree_coord_t *rect, const void *item,
+                      const rtree_coord_t *other_rect, const void *other_item,
+                      void *udata)
+{
+    struct join_ctx *ctx = udata;
+    int a = *(int*)item;
+    int b = *(int*)other_item;
+    assert(a != b);
+    assert(!ctx->seen[a*ctx->N+b] && !ctx->seen[b*ctx->N+a]);
+    ctx->seen[a*ctx->N+b] = 1;
+    return true;
+}
+
+// check_self_join compares rtree_self_join with every pair checked by hand,
+// which must each come out once.
+static void check_self_join(struct rtree *rtree, rtree_coord_t *rects, int N,
+                            int dims, rtree_coord_t pad)
+{
+    struct join_ctx ctx = { .N = N };
+    while(!(ctx.seen = xmalloc(N*N+1))){}
+    memset(ctx.seen, 0, N*N);
+    assert(rtree_self_join(rtree, pad, join_iter, &ctx));
+    for (int a = 0; a < N; a++) {
+        for (int b = a+1; b < N; b++) {
+            rtree_coord_t *ra = &rects[dims*2*a];
+            rtree_coord_t *rb = &rects[dims*2*b];
+            bool near = true;
+            for (int i = 0; i < dims; i++) {
+                if (ra[dims+i] + pad < rb[i] || rb[dims+i] + pad < ra[i]) {
+                    near = false;
+                }
+            }
+            assert(near == (ctx.seen[a*N+b] || ctx.seen[b*N+a]));
+        }
+    }
+    xfree(ctx.seen);
+}
+
 static void test(int N, int dims) {
-    double *rects;
+    rtree_coord_t *rects;
     bool use_cities = false;
 #ifdef CITIES
     if (N ==0 && dims == 0) {
         use_cities = true;
         N = sizeof(cities)/sizeof(int[2]);
         dims = 2;
-        while(!(rects = xmalloc(8*dims*2*N))){}
+        while(!(rects = xmalloc(sizeof(rtree_coord_t)*dims*2*N))){}
         assert(rects);
         for (int i = 0; i < N; i++) {
-            double *point = &rects[dims*2*i];
+            rtree_coord_t *point = &rects[dims*2*i];
             point[0] = (double)cities[i*2+0] / 1000.0 - 180.0;
             point[1] = (double)cities[i*2+1] / 1000.0 - 90.0;
             point[2] = (double)cities[i*2+0] / 1000.0 - 180.0;
@@ -1076,10 +1741,10 @@ static void test(int N, int dims) {
     }
 #endif
     if (!use_cities) {
-        while(!(rects = xmalloc(8*dims*2*N))){}
+        while(!(rects = xmalloc(sizeof(rtree_coord_t)*dims*2*N))){}
         assert(rects);
         for (int i = 0; i < N; i++) {
-            double *rect = &rects[dims*2*i];
+            rtree_coord_t *rect = &rects[dims*2*i];
             for (int j = 0; j < dims; j++) {
                 rect[j] = (double)rand()/RAND_MAX * 100;
                 rect[dims+j] = rect[j] + (double)rand()/RAND_MAX;
@@ -1099,7 +1764,7 @@ static void test(int N, int dims) {
     shuffle(vals, N, sizeof(int));
     for (int i = 0; i < N; i++) {
         int index = vals[i];
-        double *rect = &rects[dims*2*index];
+        rtree_coord_t *rect = &rects[dims*2*index];
         assert(!rtree_delete(rtree, rect, &index));
         assert(!tsearch(rtree, dims, rect, index));
         while (!rtree_insert(rtree, rect, &index)){}
@@ -1115,6 +1780,10 @@ static void test(int N, int dims) {
         rtree_deep_check(rtree);
     }
     rtree_deep_check(rtree);
+    if (!use_cities) {
+        check_self_join(rtree, rects, N, dims, 0);
+        check_self_join(rtree, rects, N, dims, 1);
+    }
     
     if (use_cities) {
         rtree_write_svg(rtree, "cities.svg");
@@ -1127,7 +1796,7 @@ static void test(int N, int dims) {
     double del = 0.50;
     for (int i = 0; i < N*del; i++) {
         int index = vals[i];
-        double *rect = &rects[dims*2*index];
+        rtree_coord_t *rect = &rects[dims*2*index];
         assert(rtree_delete(rtree, rect, &index));
     }
     if (use_cities) {
@@ -1138,7 +1807,7 @@ static void test(int N, int dims) {
 
     for (int i = 0; i < N*del; i++) {
         int index = vals[i];
-        double *rect = &rects[dims*2*index];
+        rtree_coord_t *rect = &rects[dims*2*index];
         while (!rtree_insert(rtree, rect, &index)){}
     }
 
@@ -1151,15 +1820,44 @@ static void test(int N, int dims) {
     shuffle(vals, N, sizeof(int));
     for (int i = 0; i < N; i++) {
         int index = vals[i];
-        double *rect = &rects[dims*2*index];
+        rtree_coord_t *rect = &rects[dims*2*index];
         assert(tsearch(rtree, dims, rect, index));
     }
 
+    // move every item in place, by a little or far enough to leave its leaf,
+    // and then back again
+    rtree_coord_t *moved;
+    while(!(moved = xmalloc(sizeof(rtree_coord_t)*dims*2*N+1))){}
+    for (int i = 0; i < N; i++) {
+        int shift = (i%4 == 0) ? 50 : (i%4 == 1) ? 1 : 0;
+        for (int j = 0; j < dims*2; j++) {
+            moved[dims*2*i+j] = rects[dims*2*i+j] + shift;
+        }
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        rtree_coord_t *from = pass == 0 ? rects : moved;
+        rtree_coord_t *to = pass == 0 ? moved : rects;
+        shuffle(vals, N, sizeof(int));
+        for (int i = 0; i < N; i++) {
+            int index = vals[i];
+            while (!rtree_update(rtree, &from[dims*2*index], 
+                                 &to[dims*2*index], &index))
+            {
+                // no memory for the fallback, the item stays where it was
+                assert(rtree_count(rtree) == N);
+                assert(tsearch(rtree, dims, &from[dims*2*index], index));
+            }
+            assert(rtree_count(rtree) == N);
+            assert(tsearch(rtree, dims, &to[dims*2*index], index));
+            rtree_deep_check(rtree);
+        }
+    }
+    xfree(moved);
 
     shuffle(vals, N, sizeof(int));
     for (int i = 0; i < N; i++) {
         int index = vals[i];
-        double *rect = &rects[dims*2*index];
+        rtree_coord_t *rect = &rects[dims*2*index];
         assert(tsearch(rtree, dims, rect, index));
         assert(rtree_count(rtree) == N-i);
         rtree_delete(rtree, rect, &index);
@@ -1172,6 +1870,128 @@ static void test(int N, int dims) {
 
 
 
+    // bulk load everything into the now empty tree. The load reorders its
+    // input, so it gets copies.
+    rtree_coord_t *brects;
+    int *bvals;
+    while(!(brects = xmalloc(sizeof(rtree_coord_t)*dims*2*N+1))){}
+    while(!(bvals = xmalloc(sizeof(int)*N+1))){}
+    memcpy(brects, rects, sizeof(rtree_coord_t)*dims*2*N);
+    for (int i = 0; i < N; i++) {
+        bvals[i] = i;
+    }
+    // a failed load must leave an empty tree behind, retry without failures
+    if (!rtree_bulk_load(rtree, brects, bvals, N)) {
+        assert(rtree_count(rtree) == 0);
+        rtree_deep_check(rtree);
+        bool fail = rand_alloc_fail;
+        rand_alloc_fail = false;
+        assert(rtree_bulk_load(rtree, brects, bvals, N));
+        rand_alloc_fail = fail;
+    }
+    assert(rtree_count(rtree) == N);
+    rtree_deep_check(rtree);
+    for (int i = 0; i < N; i++) {
+        assert(tsearch(rtree, dims, &rects[dims*2*i], i));
+    }
+    check_self_join(rtree, rects, N, dims, 0);
+    xfree(bvals);
+    xfree(brects);
+
+    rtree_free(rtree);
+    xfree(vals);
+    xfree(rects);
+    if (total_allocs != 0) {
+        fprintf(stderr, "total_allocs: expected 0, got %lu\n", total_allocs);
+        exit(1);
+    }
+}
+
+// test_arena runs the rtree on a static node arena. Once the arena is set,
+// nothing may go through the allocator, and running out of slabs must fail
+// inserts the same way running out of memory does.
+static void test_arena(int N, int dims) {
+    static uint64_t arena[RTREE_ARENA_SIZE(sizeof(int), 64, 16)/8];
+    rtree_coord_t *rects;
+    while(!(rects = xmalloc(sizeof(rtree_coord_t)*dims*2*N+1))){}
+    for (int i = 0; i < N; i++) {
+        rtree_coord_t *rect = &rects[dims*2*i];
+        for (int j = 0; j < dims; j++) {
+            rect[j] = (double)rand()/RAND_MAX * 100;
+            rect[dims+j] = rect[j] + (double)rand()/RAND_MAX;
+        }
+    }
+    int *vals;
+    while(!(vals = xmalloc(sizeof(int)*N+1))){}
+    struct rtree *rtree;
+    while(!(rtree = rtree_new(sizeof(int), dims))){}
+    assert(!rtree_set_arena(rtree, arena, 8, 1));
+    assert(rtree_set_arena(rtree, arena, sizeof(arena), 64));
+    uintptr_t allocs = total_allocs;
+
+    // fill until the arena runs dry, everything that made it in stays there
+    int n = 0;
+    while (n < N && rtree_insert(rtree, &rects[dims*2*n], &n)) {
+        n++;
+    }
+    assert(rtree_count(rtree) == n);
+    rtree_deep_check(rtree);
+    for (int i = 0; i < n; i++) {
+        assert(tsearch(rtree, dims, &rects[dims*2*i], i));
+    }
+    size_t leaves, branches;
+    rtree_arena_peak(rtree, &leaves, &branches);
+    assert(leaves > 0 && leaves <= 64 && branches <= 16);
+
+    // with the arena full, a move that needs nodes fails and leaves the item
+    // where it was, no item is ever lost
+    rtree_coord_t *placed;
+    while(!(placed = xmalloc(sizeof(rtree_coord_t)*dims*2*n+1))){}
+    memcpy(placed, rects, sizeof(rtree_coord_t)*dims*2*n);
+    for (int i = 0; i < n; i++) {
+        rtree_coord_t *rect = &placed[dims*2*i];
+        rtree_coord_t moved[16];
+        for (int j = 0; j < dims; j++) {
+            moved[j] = 100 - rect[dims+j];
+            moved[dims+j] = 100 - rect[j];
+        }
+        if (rtree_update(rtree, rect, moved, &i)) {
+            memcpy(rect, moved, sizeof(rtree_coord_t)*dims*2);
+        }
+    }
+    assert(rtree_count(rtree) == n);
+    rtree_deep_check(rtree);
+    for (int i = 0; i < n; i++) {
+        assert(tsearch(rtree, dims, &placed[dims*2*i], i));
+    }
+    // the same inserts as above fit again once the tree is emptied
+    for (int i = 0; i < n; i++) {
+        assert(rtree_delete(rtree, &placed[dims*2*i], &i));
+    }
+    for (int i = 0; i < n; i++) {
+        assert(rtree_insert(rtree, &rects[dims*2*i], &i));
+    }
+    xfree(placed);
+
+    // freed nodes are reused, churning never needs more than the peak
+    for (int pass = 0; pass < 3; pass++) {
+        for (int i = 0; i < n; i++) {
+            assert(rtree_delete(rtree, &rects[dims*2*i], &i));
+        }
+        assert(rtree_count(rtree) == 0);
+        for (int i = 0; i < n; i++) {
+            assert(rtree_insert(rtree, &rects[dims*2*i], &i));
+        }
+        rtree_deep_check(rtree);
+    }
+    for (int i = 0; i < n; i++) {
+        vals[i] = i;
+    }
+    assert(rtree_bulk_load(rtree, rects, vals, n));
+    assert(rtree_count(rtree) == n);
+    rtree_deep_check(rtree);
+    assert(total_allocs == allocs);
+
     rtree_free(rtree);
     xfree(vals);
     xfree(rects);
@@ -1190,13 +2010,18 @@ static void all() {
 
     rand_alloc_fail = true;
 
-    for (int dims = 1; dims <= 8; dims++) {
+#if RTREE_DIMS
+    for (int dims = RTREE_DIMS; dims <= RTREE_DIMS; dims++) {
+#else
+    for (int dims = 1; dims <= MAXDIMS; dims++) {
+#endif
         printf("(%d) => ", dims);
         for (int i = 0; i < sizeof(counts)/sizeof(int); i++) {
             printf("%d ", counts[i]);
             fflush(stdout);
             test(counts[i], dims);
         }
+        test_arena(5000, dims);
         printf("\n");
     }
 #ifdef CITIES
@@ -1247,37 +2072,41 @@ static void benchmarks() {
     printf("seed=%d count=%d\n", seed, N);
     srand(seed);
 
-    double *coords = xmalloc(8*dims*2*N);
+    rtree_coord_t *coords = xmalloc(sizeof(rtree_coord_t)*dims*2*N);
     for (int i = 0; i < N; i++) {
-        double *point = &coords[dims*2*i];
+        rtree_coord_t *point = &coords[dims*2*i];
         copy_rand_point(dims, point);
     }
 
     struct rtree *rtree = rtree_new(sizeof(int), dims);
 
     bench("insert", N, {
-        double *point = &coords[dims*2*i];
+        rtree_coord_t *point = &coords[dims*2*i];
         rtree_insert(rtree, point, &(int){i});
     });
 
     rtree_write_svg(rtree, "out.svg");
 
     bench("search", N, {
-        double *point = &coords[dims*2*i];
+        rtree_coord_t *point = &coords[dims*2*i];
         int res = 0;
         rtree_search(rtree, point, search_iter, &res);
+#ifdef RTREE_INT16
+        assert(res >= 1); // whole pixel points can coincide
+#else
         assert(res == 1);
+#endif
     });
 
     bench("replace", N, {
-        double *point = &coords[dims*2*i];
+        rtree_coord_t *point = &coords[dims*2*i];
         rtree_delete(rtree, point, &(int){i});
         rtree_insert(rtree, point, &(int){i});
     });
 
 
     bench("delete", N, {
-        double *point = &coords[dims*2*i];
+        rtree_coord_t *point = &coords[dims*2*i];
         rtree_delete(rtree, point, &(int){i});
     });
 
@@ -7,6 +7,8 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <math.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -15,18 +17,77 @@ extern "C"
 
 struct rtree;
 
-bool rtree_insert(struct rtree *rtree, double *rect, void *item);
+// Number of dimensions, fixed at compile time so every rect size and loop in rtree.c is a constant. The app only
+// keeps screen space rects. 0 lets rtree_new() pick any number of dimensions, as upstream does.
+#ifndef RTREE_DIMS
+#define RTREE_DIMS 2
+#endif
+
+// Coordinate type of every rect. The Cortex-M4 FPU only does single precision, so the tree stores and compares floats
+// unless RTREE_DOUBLE is defined. RTREE_INT16 stores whole pixels instead, which is enough for the 240x320 LCD and
+// compares in the integer pipeline.
+#if defined(RTREE_DOUBLE)
+typedef double rtree_coord_t;
+#elif defined(RTREE_INT16)
+typedef int16_t rtree_coord_t;
+#else
+typedef float rtree_coord_t;
+#endif
+
+// Convert float bounds to coordinates without shrinking the rect, for the min and max corner respectively
+#ifdef RTREE_INT16
+#define RTREE_COORD_MIN(v) ((rtree_coord_t)floorf(v))
+#define RTREE_COORD_MAX(v) ((rtree_coord_t)ceilf(v))
+#else
+#define RTREE_COORD_MIN(v) ((rtree_coord_t)(v))
+#define RTREE_COORD_MAX(v) ((rtree_coord_t)(v))
+#endif
+
+// Max items per node
+#define RTREE_MAXITEMS 32
+
+// Bytes of node arena, see rtree_set_arena(), that hold the given number of leaves with elsize byte items and of
+// branches. Every node takes a fixed size slab: a header of at most 32 bytes, then MAXITEMS+1 rects and items, rounded
+// up to 8 bytes. The extra 8 bytes leave room to align an unaligned buffer. With RTREE_DIMS at 0 this assumes 8 dims.
+#if RTREE_DIMS
+#define RTREE_ARENA_DIMS RTREE_DIMS
+#else
+#define RTREE_ARENA_DIMS 8
+#endif
+#define RTREE_NODE_HEADER 32
+#define RTREE_SLAB_SIZE(elsize) \
+    ((RTREE_NODE_HEADER + (sizeof(rtree_coord_t)*RTREE_ARENA_DIMS*2 + (elsize))*(RTREE_MAXITEMS+1) + 7) & ~(size_t)7)
+#define RTREE_ARENA_SIZE(elsize, leaves, branches) \
+    ((leaves)*RTREE_SLAB_SIZE(elsize) + (branches)*RTREE_SLAB_SIZE(sizeof(void*)) + 8)
+
+bool rtree_insert(struct rtree *rtree, rtree_coord_t *rect, void *item);
 struct rtree *rtree_new(size_t elsize, int dims);
 void rtree_free(struct rtree *rtree);
 size_t rtree_count(struct rtree *rtree);
-bool rtree_insert(struct rtree *rtree, double *rect, void *item);
-bool rtree_delete(struct rtree *rtree, double *rect, void *item);
-bool rtree_search(struct rtree *rtree, double *rect, 
-                  bool (*iter)(const double *rect, const void *item, 
+bool rtree_insert(struct rtree *rtree, rtree_coord_t *rect, void *item);
+bool rtree_delete(struct rtree *rtree, rtree_coord_t *rect, void *item);
+bool rtree_search(struct rtree *rtree, rtree_coord_t *rect, 
+                  bool (*iter)(const rtree_coord_t *rect, const void *item, 
                                void *udata), 
                   void *udata);
 
+bool rtree_self_join(struct rtree *rtree, rtree_coord_t pad,
+                     bool (*iter)(const rtree_coord_t *rect, 
+                                  const void *item,
+                                  const rtree_coord_t *other_rect, 
+                                  const void *other_item,
+                                  void *udata),
+                     void *udata);
+
+bool rtree_update(struct rtree *rtree, rtree_coord_t *rect, 
+                  rtree_coord_t *new_rect, void *item);
+bool rtree_bulk_load(struct rtree *rtree, rtree_coord_t *rects, void *items,
+                     size_t n);
+
 void rtree_set_allocator(void *(malloc)(size_t), void (*free)(void*));
+bool rtree_set_arena(struct rtree *rtree, void *buf, size_t size, 
+                     size_t leaves);
+void rtree_arena_peak(struct rtree *rtree, size_t *leaves, size_t *branches);
 
 #ifdef __cplusplus
 }
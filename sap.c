@@ -0,0 +1,297 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "sap.h"
+#include <string.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define STRIDED(ptr, index, stride)     (*(const float*)((const char*)(ptr) + (size_t)(index) * (stride)))
+
+#define SAP_UPPER                       0x8000
+#define SAP_ITEM(item)                  ((item) & ~SAP_UPPER)
+#define PAIR_KEY(a, b)                  (((uint32_t)(a) << 16) | (uint32_t)(b))
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Lower value first, and a lower end before an upper one of the same value, so that touching intervals overlap just
+// like overlaps() says
+static bool before(const SapEndpoint_t* a, const SapEndpoint_t* b)
+{
+    if(a->value != b->value)
+        return a->value < b->value;
+    return !(a->item & SAP_UPPER) && (b->item & SAP_UPPER);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Worked out from the ends exactly as sap_update() computes them, so it never disagrees with their order
+static bool overlaps(const float* axis, size_t stride, float extent, int a, int b)
+{
+    float centre_a = STRIDED(axis, a, stride);
+    float centre_b = STRIDED(axis, b, stride);
+
+    return centre_a - extent <= centre_b + extent && centre_b - extent <= centre_a + extent;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The product's high bits depend on the whole key, scaling them to the slot count keeps both items in the hash
+static int home_slot(const Sap_t* sap, uint32_t key)
+{
+    return (int)(((uint64_t)(key * 2654435761u) * (uint32_t)sap->slot_count) >> 32);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Slot holding the pair, or the free slot ending its probe
+static int find_slot(const Sap_t* sap, uint32_t key)
+{
+    int slot = home_slot(sap, key);
+
+    while(sap->slots[slot])
+    {
+        const SapPair_t* pair = &sap->pairs[sap->slots[slot] - 1];
+
+        if(PAIR_KEY(pair->a, pair->b) == key)
+            break;
+        if(++slot == sap->slot_count)
+            slot = 0;
+    }
+    return slot;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void add_pair(Sap_t* sap, int a, int b)
+{
+    uint32_t key = (a < b) ? PAIR_KEY(a, b) : PAIR_KEY(b, a);
+    int slot = find_slot(sap, key);
+
+    if(sap->slots[slot])
+        return;
+
+    // Out of room, the set no longer holds every overlap
+    if(sap->pair_count == sap->pair_capacity)
+    {
+        sap->tracking = false;
+        return;
+    }
+
+    sap->pairs[sap->pair_count].a = (uint16_t)(key >> 16);
+    sap->pairs[sap->pair_count].b = (uint16_t)key;
+    sap->slots[slot] = (uint16_t)++sap->pair_count;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Linear probing without tombstones: the entries after the hole move back into it unless that would put them before
+// their home slot
+static void free_slot(Sap_t* sap, int hole)
+{
+    int slot = hole;
+
+    for(;;)
+    {
+        if(++slot == sap->slot_count)
+            slot = 0;
+        if(!sap->slots[slot])
+            break;
+
+        const SapPair_t* pair = &sap->pairs[sap->slots[slot] - 1];
+        int home = home_slot(sap, PAIR_KEY(pair->a, pair->b));
+        int from_home = (slot >= home) ? slot - home : slot - home + sap->slot_count;
+        int from_hole = (slot >= hole) ? slot - hole : slot - hole + sap->slot_count;
+
+        if(from_home >= from_hole)
+        {
+            sap->slots[hole] = sap->slots[slot];
+            hole = slot;
+        }
+    }
+    sap->slots[hole] = 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void remove_pair(Sap_t* sap, int a, int b)
+{
+    uint32_t key = (a < b) ? PAIR_KEY(a, b) : PAIR_KEY(b, a);
+    int slot = find_slot(sap, key);
+    int index, last;
+
+    if(!sap->slots[slot])
+        return;
+
+    index = sap->slots[slot] - 1;
+    free_slot(sap, slot);
+
+    // The last pair fills the gap so the set stays dense
+    last = --sap->pair_count;
+    if(index != last)
+    {
+        sap->pairs[index] = sap->pairs[last];
+        sap->slots[find_slot(sap, PAIR_KEY(sap->pairs[index].a, sap->pairs[index].b))] = (uint16_t)(index + 1);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Every overlap on the sweep axis has the lower end of one item between the two ends of the other, so walking from
+// each lower end to its upper one finds them all once. Only those overlapping on cross as well are reported, unless it
+// is NULL.
+static bool sweep_pairs(const Sap_t* sap, const float* cross, bool (*iter)(int a, int b, void* udata), void* udata)
+{
+    int ends = SAP_ENDPOINTS(sap->count);
+
+    for(int i = 0; i < ends; i++)
+    {
+        int item = sap->endpoints[i].item;
+
+        if(item & SAP_UPPER)
+            continue;
+
+        for(int j = i + 1; sap->endpoints[j].item != (item | SAP_UPPER); j++)
+        {
+            int other = sap->endpoints[j].item;
+
+            if(other & SAP_UPPER)
+                continue;
+            if(cross && !overlaps(cross, sap->stride, sap->extent, item, other))
+                continue;
+            if(!iter(item, other, udata))
+                return false;
+        }
+    }
+
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Counts down the room left, stops once there is none
+static bool fits_pair(int a, int b, void* udata)
+{
+    int* room = (int*)udata;
+
+    return --*room >= 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool collect_pair(int a, int b, void* udata)
+{
+    Sap_t* sap = (Sap_t*)udata;
+
+    add_pair(sap, a, b);
+    return sap->tracking;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void sap_init(Sap_t* sap, float extent, SapEndpoint_t* endpoints, SapPair_t* pairs, int pair_capacity,
+              uint16_t* slots)
+{
+    sap->extent = extent;
+    sap->count = 0;
+    sap->tracking = false;
+    sap->endpoints = endpoints;
+    sap->pairs = pairs;
+    sap->pair_count = 0;
+    sap->pair_capacity = pair_capacity;
+    sap->slots = slots;
+    sap->slot_count = SAP_SLOTS(pair_capacity);
+    sap->sweep = NULL;
+    sap->cross = NULL;
+    sap->stride = 0;
+    sap->swaps = 0;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void sap_update(Sap_t* sap, const float* sweep, const float* cross, size_t stride, int count)
+{
+    SapEndpoint_t* ends = sap->endpoints;
+
+    // New items start over from their own order, the first insertion sort after that is the only slow one
+    if(count != sap->count)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            ends[2 * i].item = (uint16_t)i;
+            ends[2 * i + 1].item = (uint16_t)(i | SAP_UPPER);
+        }
+        sap->count = count;
+        sap->tracking = false;
+    }
+
+    sap->sweep = sweep;
+    sap->cross = cross;
+    sap->stride = stride;
+    sap->swaps = 0;
+
+    for(int i = 0; i < SAP_ENDPOINTS(count); i++)
+    {
+        int item = SAP_ITEM(ends[i].item);
+        float centre = STRIDED(sweep, item, stride);
+
+        ends[i].value = (ends[i].item & SAP_UPPER) ? centre + sap->extent : centre - sap->extent;
+    }
+
+    for(int i = 1; i < SAP_ENDPOINTS(count); i++)
+    {
+        SapEndpoint_t moving = ends[i];
+        int j = i;
+
+        while(j > 0 && before(&moving, &ends[j - 1]))
+        {
+            const SapEndpoint_t* passed = &ends[j - 1];
+
+            // A lower end passing an upper one may start an overlap, an upper end passing a lower one ends one. Both
+            // items may still move past each other entirely, so the new positions have the last word on a start.
+            if(sap->tracking && (moving.item & SAP_UPPER) != (passed->item & SAP_UPPER))
+            {
+                int a = SAP_ITEM(moving.item);
+                int b = SAP_ITEM(passed->item);
+
+                if(moving.item & SAP_UPPER)
+                    remove_pair(sap, a, b);
+                else if(overlaps(sweep, stride, sap->extent, a, b))
+                    add_pair(sap, a, b);
+            }
+
+            ends[j] = ends[j - 1];
+            j--;
+            sap->swaps++;
+        }
+        ends[j] = moving;
+    }
+
+    // Lost track, or never had it: collect the set again from the sorted ends, once a plain count says it fits. Until
+    // then the pairs are swept for, which is cheaper than filling the set every step only to overflow it.
+    if(!sap->tracking)
+    {
+        int room = sap->pair_capacity;
+
+        if(!sweep_pairs(sap, NULL, fits_pair, &room))
+            return;
+
+        sap->pair_count = 0;
+        memset(sap->slots, 0, sap->slot_count * sizeof(uint16_t));
+        sap->tracking = true;
+        sweep_pairs(sap, NULL, collect_pair, sap);
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool sap_pairs(const Sap_t* sap, bool (*iter)(int a, int b, void* udata), void* udata)
+{
+    if(!sap->tracking)
+        return sweep_pairs(sap, sap->cross, iter, udata);
+
+    for(int i = 0; i < sap->pair_count; i++)
+    {
+        const SapPair_t* pair = &sap->pairs[i];
+
+        if(overlaps(sap->cross, sap->stride, sap->extent, pair->a, pair->b) && !iter(pair->a, pair->b, udata))
+            return false;
+    }
+
+    return true;
+}
+// ---------------------------------------------------------------------------------------------------------------------
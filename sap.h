@@ -0,0 +1,82 @@
+#ifndef __SAP_H
+#define __SAP_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define SAP_ENDPOINTS(count)            (2 * (count))
+// Hash slots for a pair capacity, half of them stay free so the probes are short
+#define SAP_SLOTS(pairs)                (2 * (pairs))
+// Most pairs the set can index
+#define SAP_MAX_PAIRS                   65535
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// One end of an item's interval on the sweep axis
+typedef struct SapEndpoint_s
+{
+    float value;
+    uint16_t item;              // top bit set for the upper end
+}SapEndpoint_t;
+
+typedef struct SapPair_s
+{
+    uint16_t a;                 // a < b
+    uint16_t b;
+}SapPair_t;
+
+// Sweep and prune over items that are squares of the same half size. The interval ends along the sweep axis stay
+// sorted from one update to the next, so the insertion sort that brings them up to date is close to linear when the
+// items only moved a little, and each swap of two ends is exactly where two intervals start or stop overlapping. The
+// overlapping pairs are kept in a set updated by those swaps, the other axis is only checked when they are reported.
+// All storage is supplied by the caller: endpoints needs SAP_ENDPOINTS() entries, slots needs SAP_SLOTS() of the pair
+// capacity. Items are at most 32767. When the overlaps do not fit in the set the pairs are found by sweeping the
+// sorted ends instead, until they fit again.
+typedef struct Sap_s
+{
+    float extent;               // half the size of an item, two overlap when they are at most 2 * extent apart
+    int count;
+    bool tracking;              // the set holds every overlap on the sweep axis
+    SapEndpoint_t* endpoints;
+    SapPair_t* pairs;
+    int pair_count;
+    int pair_capacity;
+    uint16_t* slots;            // pair index + 1 for every pair in the set, 0 for a free slot
+    int slot_count;
+    // Positions given to the last update, which the pairs are reported for
+    const float* sweep;
+    const float* cross;
+    size_t stride;
+
+    uint32_t swaps;             // ends swapped by the last update
+}Sap_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+void sap_init(Sap_t* sap, float extent, SapEndpoint_t* endpoints, SapPair_t* pairs, int pair_capacity,
+              uint16_t* slots);
+// sweep and cross are the item centres along the two axes, the positions must stay valid until the pairs are reported
+void sap_update(Sap_t* sap, const float* sweep, const float* cross, size_t stride, int count);
+bool sap_pairs(const Sap_t* sap, bool (*iter)(int a, int b, void* udata), void* udata);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SAP_H */
@@ -0,0 +1,132 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "sprites.h"
+#include "lcd_dma2d.h"
+#include "stm32f429i_discovery_lcd.h"
+#include <math.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static Sprite_t cache[SPRITE_CACHE_SIZE];
+static int cached;
+static uint8_t pool[SPRITE_POOL_SIZE];
+static int pool_used;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+// One pixel wide ring, each pixel covered by how far its centre is from the circle
+static void render_circle(uint8_t* alpha, uint16_t radius)
+{
+    int size = SPRITE_SIZE(radius);
+
+    for(int y = 0; y < size; y++)
+    {
+        for(int x = 0; x < size; x++)
+        {
+            float dx = (float)(x - radius);
+            float dy = (float)(y - radius);
+            float coverage = 1.0f - fabsf(sqrtf(dx * dx + dy * dy) - (float)radius);
+
+            alpha[x + size * y] = coverage > 0.0f ? (uint8_t)(coverage * 255.0f + 0.5f) : 0;
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+const Sprite_t* sprite_circle(uint16_t radius)
+{
+    Sprite_t* sprite;
+    int size = SPRITE_SIZE(radius);
+
+    for(int i = 0; i < cached; i++)
+    {
+        if(cache[i].radius == radius)
+            return &cache[i];
+    }
+
+    if(cached == SPRITE_CACHE_SIZE || pool_used + size * size > SPRITE_POOL_SIZE)
+        return NULL;
+
+    sprite = &cache[cached++];
+    sprite->radius = radius;
+    sprite->size = (uint16_t)size;
+    sprite->alpha = &pool[pool_used];
+    render_circle(&pool[pool_used], radius);
+    pool_used += size * size;
+    return sprite;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void sprite_draw(const Sprite_t* sprite, int x, int y, uint16_t color)
+{
+    sprite_draw_clipped(sprite, x, y, color, 0, 0, LCD_PIXEL_WIDTH, LCD_PIXEL_HEIGHT);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void sprite_draw_clipped(const Sprite_t* sprite, int x, int y, uint16_t color, int clip_left, int clip_top,
+                         int clip_right, int clip_bottom)
+{
+    int left = x - sprite->radius;
+    int top = y - sprite->radius;
+    int right = left + sprite->size;
+    int bottom = top + sprite->size;
+    const uint8_t* alpha = sprite->alpha;
+
+    if(clip_left < 0)
+        clip_left = 0;
+    if(clip_top < 0)
+        clip_top = 0;
+    if(clip_right > LCD_PIXEL_WIDTH)
+        clip_right = LCD_PIXEL_WIDTH;
+    if(clip_bottom > LCD_PIXEL_HEIGHT)
+        clip_bottom = LCD_PIXEL_HEIGHT;
+
+    if(left < clip_left)
+    {
+        alpha += clip_left - left;
+        left = clip_left;
+    }
+    if(top < clip_top)
+    {
+        alpha += (clip_top - top) * sprite->size;
+        top = clip_top;
+    }
+    if(right > clip_right)
+        right = clip_right;
+    if(bottom > clip_bottom)
+        bottom = clip_bottom;
+
+    if(left >= right || top >= bottom)
+        return;
+
+    lcd_dma2d_blend((uint16_t)left, (uint16_t)top, (uint16_t)(right - left), (uint16_t)(bottom - top), alpha,
+                    sprite->size, color);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint16_t sprite_blend_pixel(uint16_t color, uint16_t background, uint8_t alpha)
+{
+    uint32_t fg_r = (color >> 11) & 0x1F, fg_g = (color >> 5) & 0x3F, fg_b = color & 0x1F;
+    uint32_t bg_r = (background >> 11) & 0x1F, bg_g = (background >> 5) & 0x3F, bg_b = background & 0x1F;
+    uint32_t r, g, b;
+
+    fg_r = fg_r << 3 | fg_r >> 2;
+    fg_g = fg_g << 2 | fg_g >> 4;
+    fg_b = fg_b << 3 | fg_b >> 2;
+    bg_r = bg_r << 3 | bg_r >> 2;
+    bg_g = bg_g << 2 | bg_g >> 4;
+    bg_b = bg_b << 3 | bg_b >> 2;
+
+    r = (fg_r * alpha + bg_r * (255 - alpha)) / 255;
+    g = (fg_g * alpha + bg_g * (255 - alpha)) / 255;
+    b = (fg_b * alpha + bg_b * (255 - alpha)) / 255;
+    return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+// ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,54 @@
+#ifndef __SPRITES_H
+#define __SPRITES_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define SPRITE_CACHE_SIZE               4
+#define SPRITE_POOL_SIZE                2048
+#define SPRITE_SIZE(radius)             (2 * (radius) + 1)
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Anti-aliased circle outline as an A8 coverage mask, size * size bytes centred on the middle pixel. It holds no
+// color: the DMA2D tints it while blending, so one mask serves every particle of the same radius.
+typedef struct Sprite_s
+{
+    uint16_t radius;
+    uint16_t size;
+    const uint8_t* alpha;
+}Sprite_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the cached mask for radius, rendering it into a static pool on first use. NULL once the cache or the pool is
+// full, the caller then has to draw the circle some other way.
+const Sprite_t* sprite_circle(uint16_t radius);
+// Queues a blend of the sprite centred on (x, y) into the frame buffer through lcd_dma2d, clipped to the screen or to
+// the given rect, right and bottom exclusive
+void sprite_draw(const Sprite_t* sprite, int x, int y, uint16_t color);
+void sprite_draw_clipped(const Sprite_t* sprite, int x, int y, uint16_t color, int clip_left, int clip_top,
+                         int clip_right, int clip_bottom);
+// One RGB565 pixel of color painted over background through an A8 mask value, for blending done by the CPU. Same
+// arithmetic as the DMA2D blender: both colors are expanded to 8 bits per channel and mixed by the mask.
+uint16_t sprite_blend_pixel(uint16_t color, uint16_t background, uint8_t alpha);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPRITES_H */
@@ -29,6 +29,8 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "global_includes.h"
+#include "display.h"
+#include "lcd_dma2d.h"
 
 /** @addtogroup STM32F429I_DISCOVERY_Examples
   * @{
@@ -165,6 +167,26 @@ void SysTick_Handler(void)
 {
 }*/
 
+/**
+  * @brief  This function handles LTDC global interrupt request.
+  * @param  None
+  * @retval None
+  */
+void LTDC_IRQHandler(void)
+{
+    display_reload_isr();
+}
+
+/**
+  * @brief  This function handles DMA2D global interrupt request.
+  * @param  None
+  * @retval None
+  */
+void DMA2D_IRQHandler(void)
+{
+    lcd_dma2d_isr();
+}
+
 
 /**
   * @}
@@ -48,6 +48,8 @@ void SVC_Handler(void);
 void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
+void LTDC_IRQHandler(void);
+void DMA2D_IRQHandler(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,167 @@
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "tiles.h"
+#include "lcd_dma2d.h"
+#include <string.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private variables
+// ---------------------------------------------------------------------------------------------------------------------
+static uint16_t tile_buffer[TILE_BUFFERS][TILE_SIZE * TILE_SIZE];
+// The copy that last read each tile buffer, it must be done before the buffer is rendered into again
+static uint32_t tile_fence[TILE_BUFFERS];
+static int next_buffer;
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Private functions
+// ---------------------------------------------------------------------------------------------------------------------
+static int clamp(int value, int low, int high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void tile_span(const TileBins_t* bins, int x, int y, int radius, int* col0, int* row0, int* col1, int* row1)
+{
+    *col0 = clamp(x - radius, 0, bins->width - 1) / TILE_SIZE;
+    *row0 = clamp(y - radius, 0, bins->height - 1) / TILE_SIZE;
+    *col1 = clamp(x + radius, 0, bins->width - 1) / TILE_SIZE;
+    *row1 = clamp(y + radius, 0, bins->height - 1) / TILE_SIZE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Blends the part of the sprite centred on (x, y) that falls inside the tile at (left, top)
+static void render_sprite(uint16_t* pixels, int left, int top, int width, int height, const Sprite_t* sprite, int x,
+                          int y, uint16_t color)
+{
+    int sx0 = x - sprite->radius - left;
+    int sy0 = y - sprite->radius - top;
+    int tx0 = sx0 < 0 ? 0 : sx0;
+    int ty0 = sy0 < 0 ? 0 : sy0;
+    int tx1 = sx0 + sprite->size > width ? width : sx0 + sprite->size;
+    int ty1 = sy0 + sprite->size > height ? height : sy0 + sprite->size;
+
+    for(int ty = ty0; ty < ty1; ty++)
+    {
+        const uint8_t* alpha = &sprite->alpha[(ty - sy0) * sprite->size];
+        uint16_t* row = &pixels[ty * TILE_SIZE];
+
+        for(int tx = tx0; tx < tx1; tx++)
+        {
+            uint8_t a = alpha[tx - sx0];
+
+            // Most of a ring sprite is transparent
+            if(a == 0)
+                continue;
+            row[tx] = a == 255 ? color : sprite_blend_pixel(color, row[tx], a);
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------------------------------------------------
+void tiles_init(TileBins_t* bins, int width, int height, uint16_t* tile_start, uint16_t* items)
+{
+    bins->width = width;
+    bins->height = height;
+    bins->cols = TILE_COLS(width);
+    bins->rows = TILE_ROWS(height);
+    bins->tile_start = tile_start;
+    bins->items = items;
+
+    memset(bins->tile_start, 0, (bins->cols * bins->rows + 1) * sizeof(uint16_t));
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void tiles_bin(TileBins_t* bins, const int16_t* x, const int16_t* y, int count, int radius)
+{
+    int tiles = bins->cols * bins->rows;
+    int col0, row0, col1, row1;
+
+    memset(bins->tile_start, 0, (tiles + 1) * sizeof(uint16_t));
+
+    // Histogram, then turn it into running end offsets
+    for(int i = 0; i < count; i++)
+    {
+        tile_span(bins, x[i], y[i], radius, &col0, &row0, &col1, &row1);
+        for(int row = row0; row <= row1; row++)
+        {
+            for(int col = col0; col <= col1; col++)
+            {
+                bins->tile_start[row * bins->cols + col]++;
+            }
+        }
+    }
+
+    for(int t = 1; t <= tiles; t++)
+    {
+        bins->tile_start[t] += bins->tile_start[t - 1];
+    }
+
+    // Scattering backwards walks every end offset down to its start offset and keeps each tile in index order
+    for(int i = count - 1; i >= 0; i--)
+    {
+        tile_span(bins, x[i], y[i], radius, &col0, &row0, &col1, &row1);
+        for(int row = row0; row <= row1; row++)
+        {
+            for(int col = col0; col <= col1; col++)
+            {
+                bins->items[--bins->tile_start[row * bins->cols + col]] = (uint16_t)i;
+            }
+        }
+    }
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void tiles_bounds(const TileBins_t* bins, int tile, int* left, int* top, int* right, int* bottom)
+{
+    *left = (tile % bins->cols) * TILE_SIZE;
+    *top = (tile / bins->cols) * TILE_SIZE;
+    *right = *left + TILE_SIZE > bins->width ? bins->width : *left + TILE_SIZE;
+    *bottom = *top + TILE_SIZE > bins->height ? bins->height : *top + TILE_SIZE;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+void tiles_draw(const TileBins_t* bins, int tile, const Sprite_t* sprite, const int16_t* x, const int16_t* y,
+                const uint16_t* color, uint16_t background)
+{
+    int left, top, right, bottom;
+    int width, height;
+    uint16_t* pixels;
+
+    tiles_bounds(bins, tile, &left, &top, &right, &bottom);
+    width = right - left;
+    height = bottom - top;
+
+    if(bins->tile_start[tile] == bins->tile_start[tile + 1])
+    {
+        lcd_dma2d_fill((uint16_t)left, (uint16_t)top, (uint16_t)width, (uint16_t)height, background);
+        return;
+    }
+
+    pixels = tile_buffer[next_buffer];
+    lcd_dma2d_wait_fence(tile_fence[next_buffer]);
+
+    for(int row = 0; row < height; row++)
+    {
+        for(int col = 0; col < width; col++)
+        {
+            pixels[row * TILE_SIZE + col] = background;
+        }
+    }
+
+    for(int i = bins->tile_start[tile]; i < bins->tile_start[tile + 1]; i++)
+    {
+        int item = bins->items[i];
+        render_sprite(pixels, left, top, width, height, sprite, x[item], y[item], color[item]);
+    }
+
+    lcd_dma2d_copy((uint16_t)left, (uint16_t)top, (uint16_t)width, (uint16_t)height, pixels, TILE_SIZE);
+    tile_fence[next_buffer] = lcd_dma2d_fence();
+    next_buffer = (next_buffer + 1) % TILE_BUFFERS;
+}
+// ---------------------------------------------------------------------------------------------------------------------
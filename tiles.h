@@ -0,0 +1,61 @@
+#ifndef __TILES_H
+#define __TILES_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "sprites.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Defines/macros
+// ---------------------------------------------------------------------------------------------------------------------
+#define TILE_SIZE                       32
+#define TILE_BUFFERS                    2
+#define TILE_COLS(width)                (((width) + TILE_SIZE - 1) / TILE_SIZE)
+#define TILE_ROWS(height)               (((height) + TILE_SIZE - 1) / TILE_SIZE)
+#define TILE_COUNT(width, height)       (TILE_COLS(width) * TILE_ROWS(height))
+// Most tiles a sprite of the radius can reach along one axis, and the bin entries count of them need
+#define TILE_SPAN(radius)               ((SPRITE_SIZE(radius) + TILE_SIZE - 2) / TILE_SIZE + 1)
+#define TILE_ITEMS(count, radius)       ((count) * TILE_SPAN(radius) * TILE_SPAN(radius))
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Typedefs
+// ---------------------------------------------------------------------------------------------------------------------
+// Sprites binned by every screen tile they reach, rebuilt from scratch with a counting sort like Grid_t. Inside a tile
+// they keep their index order, so a tile comes out the same as drawing all of them in order. All storage is supplied
+// by the caller: tile_start needs TILE_COUNT() + 1 entries and items TILE_ITEMS() entries.
+typedef struct TileBins_s
+{
+    int width;
+    int height;
+    int cols;
+    int rows;
+    uint16_t* tile_start;
+    uint16_t* items;
+}TileBins_t;
+// ---------------------------------------------------------------------------------------------------------------------
+
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Exported functions
+// ---------------------------------------------------------------------------------------------------------------------
+void tiles_init(TileBins_t* bins, int width, int height, uint16_t* tile_start, uint16_t* items);
+void tiles_bin(TileBins_t* bins, const int16_t* x, const int16_t* y, int count, int radius);
+// Right and bottom are exclusive
+void tiles_bounds(const TileBins_t* bins, int tile, int* left, int* top, int* right, int* bottom);
+// Renders the tile's sprites into an internal SRAM tile on the CPU and queues one lcd_dma2d_copy() of it into the
+// frame buffer, while the DMA2D flushes one tile the CPU renders the next. A tile nothing reaches is a DMA2D fill.
+void tiles_draw(const TileBins_t* bins, int tile, const Sprite_t* sprite, const int16_t* x, const int16_t* y,
+                const uint16_t* color, uint16_t background);
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TILES_H */
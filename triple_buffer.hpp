@@ -0,0 +1,52 @@
+#ifndef __TRIPLE_BUFFER_H
+#define __TRIPLE_BUFFER_H
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <atomic>
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Class
+// ---------------------------------------------------------------------------------------------------------------------
+// One producer hands whole values over to one consumer without locks. Each side owns one slot, the third one sits in
+// between and is traded with a single atomic exchange: the producer puts its finished slot there, the consumer takes
+// it when it is fresher than the one it holds. Neither side ever waits, the consumer just keeps the latest value.
+template <typename T>
+class TripleBuffer
+{
+    public:
+        TripleBuffer(void) : write_index(0), read_index(1), middle(2) {}
+
+        // Slot the producer fills, owned by it until publish()
+        T* back(void)
+        {
+            return &slots[write_index];
+        }
+
+        void publish(void)
+        {
+            write_index = middle.exchange((uint8_t)(write_index | FRESH), std::memory_order_acq_rel) & INDEX;
+        }
+
+        // The latest published value, owned by the consumer until the next call
+        const T* latest(void)
+        {
+            if(middle.load(std::memory_order_relaxed) & FRESH)
+                read_index = middle.exchange(read_index, std::memory_order_acq_rel) & INDEX;
+            return &slots[read_index];
+        }
+
+    private:
+        static const uint8_t INDEX = 0x03;
+        static const uint8_t FRESH = 0x04;
+
+        T slots[3];
+        uint8_t write_index;
+        uint8_t read_index;
+        std::atomic<uint8_t> middle;
+};
+// ---------------------------------------------------------------------------------------------------------------------
+
+#endif /* __TRIPLE_BUFFER_H */
@@ -3,6 +3,7 @@
 // ---------------------------------------------------------------------------------------------------------------------
 #include "utils.h"
 #include "global_includes.h"
+#include "cpu_utils.h"
 // ---------------------------------------------------------------------------------------------------------------------
 // Defines/macros
 // ---------------------------------------------------------------------------------------------------------------------
@@ -33,4 +34,31 @@ void delayMiliSecs(uint32_t ms_)
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
+void cycle_counter_init(void)
+{
+    // The DWT is part of the debug block, it only counts once trace is enabled
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t cycle_counter_read(void)
+{
+    return DWT->CYCCNT;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint32_t cycle_counter_rate(void)
+{
+    return SystemCoreClock;
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
+uint16_t cpu_usage(void)
+{
+    return FreeRTOS_GetCPUUsage();
+}
+// ---------------------------------------------------------------------------------------------------------------------
+
 
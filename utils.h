@@ -14,6 +14,15 @@
 // Exported functions
 // ---------------------------------------------------------------------------------------------------------------------
 void delayMiliSecs(uint32_t ms_);
+
+// Free running counter for timing short stretches of code: core clock cycles read from the DWT on the target,
+// nanoseconds on the host. It wraps, so only the difference of two readings means anything.
+void cycle_counter_init(void);
+uint32_t cycle_counter_read(void);
+uint32_t cycle_counter_rate(void);
+
+// Percent of the last second the CPU was not idle, 0 on the host, which has no idle task
+uint16_t cpu_usage(void);
 // ---------------------------------------------------------------------------------------------------------------------
 
 #ifdef __cplusplus
@@ -31,8 +31,8 @@
 // ---------------------------------------------------------------------------------------------------------------------
 PVector::PVector(void) 
 {
-    this->x = 0.0;
-    this->y = 0.0;
+    this->x = 0.0f;
+    this->y = 0.0f;
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
@@ -78,11 +78,11 @@ PVector& PVector::normalize(void) {
 // ---------------------------------------------------------------------------------------------------------------------
 
 float PVector::mag(void) {
-    return sqrt(this->x * this->x + this->y * this->y);
+    return sqrtf(this->x * this->x + this->y * this->y);
 }
 // ---------------------------------------------------------------------------------------------------------------------
 
 float PVector::heading(void) {
-    return atan2(this->y, this->x);
+    return atan2f(this->y, this->x);
 }
 // ---------------------------------------------------------------------------------------------------------------------
\ No newline at end of file